@@ -0,0 +1,263 @@
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <cstdlib>
+#include "solvay_strassen.h"
+
+/*
+average latency of a single is_prime call on random odd numbers of every
+bit length, for both composite (mostly rejected in the first round) and
+prime inputs (which run every round), with the given number of random
+rounds and with the deterministic test (iterations = 0), followed by the
+effect of the trial-division prefilter on uniformly random 64-bit inputs,
+a comparison of the binary jacobi kernel against the original
+division-based one and of the SIMD strong base-2 kernels against the
+scalar test on sieved candidates.
+*/
+
+// the division-based routine SolvayStrassen::jacobi used to be
+static int64_t legacy_jacobi(uint64_t a, uint64_t b)
+{
+    if ((b == 0) or (b % 2 == 0))
+        return 0;
+
+    int64_t jac = 1;
+
+    while (a != 0)
+    {
+        while (a % 2 == 0)
+        {
+            a >>= 1;
+            if (
+                (b % 8 == 3) or
+                (b % 8 == 5)
+            ) jac = -jac;
+        }
+
+        std::swap(a, b);
+
+        if (
+            (a % 4 == 3) and
+            (b % 4 == 3)
+        ) jac = -jac;
+
+        a = a % b;
+    }
+
+    if (b == 1)
+        return jac;
+
+    return 0;
+}
+
+static std::vector<uint64_t> rand_odd(std::mt19937_64 &rng, uint32_t bits, uint32_t count)
+{
+    std::vector<uint64_t> nums(count);
+
+    for (uint64_t &num: nums)
+    {
+        num = rng();
+        if (bits < 64)
+            num &= (uint64_t(1) << bits) - 1;
+
+        num |= (uint64_t(1) << (bits - 1)) | 1;
+    }
+
+    return nums;
+}
+
+static double time_ns(const SolvayStrassen &ss, const std::vector<uint64_t> &nums, uint64_t it, uint32_t &primes)
+{
+    primes = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (const uint64_t &num: nums)
+        primes += it ? ss.is_prime(num, it) : ss.is_prime(num);
+
+    auto stop = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+
+    return nums.empty() ? 0.0 : ns / nums.size();
+}
+
+static void bench_prefilter(const SolvayStrassen &ss, std::mt19937_64 &rng, uint64_t it, uint32_t count)
+{
+    std::vector<uint64_t> nums(count);
+    for (uint64_t &num: nums)
+        num = rng();
+
+    uint32_t rejected = 0, primes_full = 0, primes_euler = 0;
+    std::mt19937_64 random(1);
+
+    auto start = std::chrono::steady_clock::now();
+    for (const uint64_t &num: nums)
+        rejected += (ss.prefilter(num) == SolvayStrassen::COMPOSITE);
+    auto mid = std::chrono::steady_clock::now();
+    for (const uint64_t &num: nums)
+        primes_euler += ss.euler_test(num, it, random);
+    auto mid_2 = std::chrono::steady_clock::now();
+    for (const uint64_t &num: nums)
+        primes_full += ss.is_prime(num, it, random);
+    auto stop = std::chrono::steady_clock::now();
+
+    double filter_ns = std::chrono::duration<double, std::nano>(mid - start).count() / count;
+    double euler_ns = std::chrono::duration<double, std::nano>(mid_2 - mid).count() / count;
+    double full_ns = std::chrono::duration<double, std::nano>(stop - mid_2).count() / count;
+
+    std::cout << "\nprefilter on " << count << " random 64-bit inputs (";
+    std::cout << N_SMALL_PRIMES << " table primes, " << U64_TRIAL_PRIMES << " tried on 64-bit):\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "  rejection rate:        " << (100.0 * rejected / count) << " %\n";
+    std::cout << "  prefilter only:        " << filter_ns << " ns/test\n";
+    std::cout << "  euler rounds only:     " << euler_ns << " ns/test (" << primes_euler << " primes)\n";
+    std::cout << "  prefilter + rounds:    " << full_ns << " ns/test (" << primes_full << " primes)\n";
+    std::cout << "  speedup:               " << std::setprecision(2) << (euler_ns / full_ns) << "x\n";
+}
+
+template <typename Jacobi>
+static double time_jacobi(const std::vector<std::pair<uint64_t, uint64_t>> &pairs, int64_t &sum, Jacobi jacobi)
+{
+    sum = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (const std::pair<uint64_t, uint64_t> &ab: pairs)
+        sum += jacobi(ab.first, ab.second);
+
+    auto stop = std::chrono::steady_clock::now();
+
+    return std::chrono::duration<double, std::nano>(stop - start).count() / pairs.size();
+}
+
+static void bench_jacobi(const SolvayStrassen &ss, std::mt19937_64 &rng, uint32_t count)
+{
+    std::cout << "\njacobi symbol (a / n), a < n, on " << count << " random pairs:\n";
+    std::cout << std::setw(5) << "bits" << std::setw(14) << "legacy ns";
+    std::cout << std::setw(14) << "binary ns" << std::setw(10) << "speedup\n";
+
+    for (uint32_t bits = 16; bits <= 64; bits += 16)
+    {
+        std::vector<uint64_t> nums = rand_odd(rng, bits, count);
+        std::vector<std::pair<uint64_t, uint64_t>> pairs;
+
+        for (const uint64_t &n: nums)
+            pairs.emplace_back(rng() % n, n);
+
+        int64_t legacy_sum, binary_sum;
+        double legacy_ns = time_jacobi(pairs, legacy_sum, legacy_jacobi);
+        double binary_ns = time_jacobi(pairs, binary_sum, [&](uint64_t a, uint64_t b) {
+            return ss.jacobi(a, b);
+        });
+
+        std::cout << std::setw(5) << bits << std::fixed << std::setprecision(1);
+        std::cout << std::setw(14) << legacy_ns << std::setw(14) << binary_ns;
+        std::cout << std::setw(8) << std::setprecision(2) << (legacy_ns / binary_ns) << "x";
+        std::cout << ((legacy_sum == binary_sum) ? "\n" : "  (results differ!)\n");
+    }
+}
+
+static void bench_simd(const SolvayStrassen &ss, std::mt19937_64 &rng, uint32_t count)
+{
+    // a sieved stream: random 64-bit candidates that survive the prefilter
+    std::vector<uint64_t> nums;
+    while (nums.size() < count)
+    {
+        uint64_t num = rng() | (uint64_t(1) << 63) | 1;
+        if (ss.prefilter(num) == SolvayStrassen::UNDECIDED)
+            nums.push_back(num);
+    }
+
+    const char *name;
+    strong_base2_kernel(&name);
+
+    std::vector<uint8_t> pass(count);
+    uint32_t primes = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < count; i++)
+        pass[i] = ss.strong_test(Montgomery(nums[i]), 2);
+    auto mid = std::chrono::steady_clock::now();
+    if (__builtin_cpu_supports("avx2"))
+        for (uint32_t i = 0; i + SIMD_LANES <= count; i += SIMD_LANES)
+            strong_base2_avx2(&nums[i], &pass[i]);
+    auto mid_2 = std::chrono::steady_clock::now();
+    if (__builtin_cpu_supports("avx512f"))
+        for (uint32_t i = 0; i + SIMD_LANES <= count; i += SIMD_LANES)
+            strong_base2_avx512(&nums[i], &pass[i]);
+    auto mid_3 = std::chrono::steady_clock::now();
+    for (const uint64_t &num: nums)
+        primes += ss.is_prime(num);
+    auto mid_4 = std::chrono::steady_clock::now();
+    ss.is_prime_batch(nums.data(), pass.data(), count);
+    auto stop = std::chrono::steady_clock::now();
+
+    auto ns = [&](std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b) {
+        return std::chrono::duration<double, std::nano>(b - a).count() / count;
+    };
+
+    uint32_t batch_primes = 0;
+    for (const uint8_t &p: pass)
+        batch_primes += p;
+
+    std::cout << "\nstrong base-2 test on " << count << " sieved 64-bit candidates";
+    std::cout << " (dispatch: " << name << "):\n";
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "  scalar:                " << ns(start, mid) << " ns/test\n";
+    if (__builtin_cpu_supports("avx2"))
+        std::cout << "  avx2 x8:               " << ns(mid, mid_2) << " ns/test\n";
+    if (__builtin_cpu_supports("avx512f"))
+        std::cout << "  avx512 x8:             " << ns(mid_2, mid_3) << " ns/test\n";
+    std::cout << "\nfull deterministic test on the same candidates (" << primes << " primes):\n";
+    std::cout << "  is_prime loop:         " << ns(mid_3, mid_4) << " ns/test\n";
+    std::cout << "  is_prime_batch:        " << ns(mid_4, stop) << " ns/test";
+    std::cout << ((batch_primes == primes) ? "\n" : "  (results differ!)\n");
+    std::cout << "  speedup:               " << std::setprecision(2) << (ns(mid_3, mid_4) / ns(mid_4, stop)) << "x\n";
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t it = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 20;
+    uint32_t count = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 2000;
+
+    if ((it == 0) or (count == 0))
+    {
+        std::cerr << "Usage: " << argv[0] << " [iterations] [samples]\n";
+        return 1;
+    }
+
+    const SolvayStrassen ss;
+    std::mt19937_64 rng(0x5eed);
+
+    std::cout << "iterations per test: " << it << "\n\n";
+    std::cout << std::setw(5) << "bits" << std::setw(16) << "ns/test (odd)";
+    std::cout << std::setw(16) << "ns/test (prime)" << std::setw(10) << "primes";
+    std::cout << std::setw(14) << "det (odd)" << std::setw(14) << "det (prime)\n";
+
+    for (uint32_t bits = 4; bits <= 64; bits += 4)
+    {
+        uint32_t primes, tmp;
+        std::vector<uint64_t> nums = rand_odd(rng, bits, count);
+        double odd_ns = time_ns(ss, nums, it, primes);
+
+        // keep only the inputs that passed, they are the worst case
+        std::vector<uint64_t> prime_nums;
+        for (const uint64_t &num: nums)
+            if (ss.is_prime(num, it)) prime_nums.push_back(num);
+
+        double prime_ns = time_ns(ss, prime_nums, it, tmp);
+        double det_odd_ns = time_ns(ss, nums, 0, tmp);
+        double det_prime_ns = time_ns(ss, prime_nums, 0, tmp);
+
+        std::cout << std::setw(5) << bits << std::fixed << std::setprecision(1);
+        std::cout << std::setw(16) << odd_ns << std::setw(16) << prime_ns;
+        std::cout << std::setw(10) << primes;
+        std::cout << std::setw(14) << det_odd_ns << std::setw(14) << det_prime_ns << "\n";
+    }
+
+    bench_prefilter(ss, rng, it, count * 50);
+    bench_jacobi(ss, rng, count * 100);
+    bench_simd(ss, rng, count * 50);
+
+    return 0;
+}
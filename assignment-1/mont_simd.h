@@ -0,0 +1,288 @@
+#ifndef MONT_SIMD_H
+#define MONT_SIMD_H
+
+#include <cstdint>
+#include <algorithm>
+#include <immintrin.h>
+#include "small_primes.h"
+
+/*
+multi-lane montgomery kernels for the strong base-2 test, SIMD_LANES odd
+moduli at a time. each lane runs the same square-and-multiply schedule
+(the longest exponent in the group; leading zero bits keep a lane at 1), so
+the lanes form independent dependency chains inside one register.
+
+neither AVX2 nor AVX-512F has a 64x64->128 bit multiplication, so products
+are assembled from four 32x32->64 bit vpmuludq. a montgomery multiplication
+costs eleven of those, and multiplying by the base 2 is a modular doubling.
+
+the kernels are compiled with target attributes and picked at run time by
+strong_base2_kernel(), which returns nullptr when neither instruction set is
+available so the caller can fall back to the scalar path.
+*/
+
+const uint32_t SIMD_LANES = 8;
+
+// writes 1 to pass[i] iff n[i] is a strong probable prime to base 2
+typedef void (*StrongBase2Kernel)(const uint64_t *, uint8_t *);
+
+struct LaneSetup
+{
+    uint64_t n_inv[SIMD_LANES];
+    uint64_t one[SIMD_LANES];
+    uint64_t d[SIMD_LANES];
+    uint64_t s[SIMD_LANES];
+    uint64_t max_d;
+    uint64_t max_s;
+};
+
+static void lane_setup(const uint64_t *n, LaneSetup &setup)
+{
+    setup.max_d = setup.max_s = 0;
+
+    for (uint32_t i = 0; i < SIMD_LANES; i++)
+    {
+        setup.n_inv[i] = inverse_mod_2_64(n[i]);
+        setup.one[i] = (0 - n[i]) % n[i];
+        setup.s[i] = __builtin_ctzll(n[i] - 1);
+        setup.d[i] = (n[i] - 1) >> setup.s[i];
+
+        setup.max_d = std::max(setup.max_d, setup.d[i]);
+        setup.max_s = std::max(setup.max_s, setup.s[i]);
+    }
+}
+
+/* AVX-512F, eight lanes per register */
+
+__attribute__((target("avx512f")))
+static inline void mul_wide_avx512(__m512i a, __m512i b, __m512i &lo, __m512i &hi)
+{
+    const __m512i mask_32 = _mm512_set1_epi64(0xffffffff);
+    __m512i a_hi = _mm512_srli_epi64(a, 32);
+    __m512i b_hi = _mm512_srli_epi64(b, 32);
+
+    __m512i p00 = _mm512_mul_epu32(a, b);
+    __m512i p01 = _mm512_mul_epu32(a, b_hi);
+    __m512i p10 = _mm512_mul_epu32(a_hi, b);
+    __m512i p11 = _mm512_mul_epu32(a_hi, b_hi);
+
+    // the middle column holds at most 34 bits, so nothing can overflow
+    __m512i mid = _mm512_add_epi64(
+        _mm512_srli_epi64(p00, 32),
+        _mm512_add_epi64(_mm512_and_si512(p01, mask_32), _mm512_and_si512(p10, mask_32))
+    );
+
+    lo = _mm512_or_si512(_mm512_slli_epi64(mid, 32), _mm512_and_si512(p00, mask_32));
+    hi = _mm512_add_epi64(
+        _mm512_add_epi64(p11, _mm512_srli_epi64(mid, 32)),
+        _mm512_add_epi64(_mm512_srli_epi64(p01, 32), _mm512_srli_epi64(p10, 32))
+    );
+}
+
+__attribute__((target("avx512f")))
+static inline __m512i mul_lo_avx512(__m512i a, __m512i b)
+{
+    __m512i p00 = _mm512_mul_epu32(a, b);
+    __m512i p01 = _mm512_mul_epu32(a, _mm512_srli_epi64(b, 32));
+    __m512i p10 = _mm512_mul_epu32(_mm512_srli_epi64(a, 32), b);
+
+    return _mm512_add_epi64(p00, _mm512_slli_epi64(_mm512_add_epi64(p01, p10), 32));
+}
+
+__attribute__((target("avx512f")))
+static inline __m512i mont_mul_avx512(__m512i a, __m512i b, __m512i n, __m512i n_inv)
+{
+    __m512i t_lo, t_hi, mn_lo, mn_hi;
+    mul_wide_avx512(a, b, t_lo, t_hi);
+    mul_wide_avx512(mul_lo_avx512(t_lo, n_inv), n, mn_lo, mn_hi);
+
+    __m512i res = _mm512_sub_epi64(t_hi, mn_hi);
+    __mmask8 borrow = _mm512_cmplt_epu64_mask(t_hi, mn_hi);
+
+    return _mm512_mask_add_epi64(res, borrow, res, n);
+}
+
+__attribute__((target("avx512f")))
+static inline __m512i mont_double_avx512(__m512i a, __m512i n)
+{
+    __m512i sum = _mm512_add_epi64(a, a);
+    __mmask8 wrap = _mm512_cmplt_epu64_mask(sum, a) | _mm512_cmpge_epu64_mask(sum, n);
+
+    return _mm512_mask_sub_epi64(sum, wrap, sum, n);
+}
+
+__attribute__((target("avx512f")))
+static void strong_base2_avx512(const uint64_t *nums, uint8_t *pass)
+{
+    LaneSetup setup;
+    lane_setup(nums, setup);
+
+    const __m512i n = _mm512_loadu_si512(nums);
+    const __m512i n_inv = _mm512_loadu_si512(setup.n_inv);
+    const __m512i one = _mm512_loadu_si512(setup.one);
+    const __m512i d = _mm512_loadu_si512(setup.d);
+    const __m512i s = _mm512_loadu_si512(setup.s);
+    const __m512i minus_one = _mm512_sub_epi64(n, one);
+
+    __m512i x = one;
+
+    for (int32_t bit = 63 - __builtin_clzll(setup.max_d); bit >= 0; bit--)
+    {
+        x = mont_mul_avx512(x, x, n, n_inv);
+
+        __mmask8 set = _mm512_test_epi64_mask(d, _mm512_set1_epi64(uint64_t(1) << bit));
+        x = _mm512_mask_mov_epi64(x, set, mont_double_avx512(x, n));
+    }
+
+    __mmask8 ok = _mm512_cmpeq_epi64_mask(x, one) | _mm512_cmpeq_epi64_mask(x, minus_one);
+
+    for (uint64_t r = 1; r < setup.max_s; r++)
+    {
+        x = mont_mul_avx512(x, x, n, n_inv);
+
+        __mmask8 live = _mm512_cmpgt_epu64_mask(s, _mm512_set1_epi64(r));
+        ok |= live & _mm512_cmpeq_epi64_mask(x, minus_one);
+    }
+
+    for (uint32_t i = 0; i < SIMD_LANES; i++)
+        pass[i] = (ok >> i) & 1;
+}
+
+/* AVX2, four lanes per register, two registers per group */
+
+__attribute__((target("avx2")))
+static inline __m256i cmpgt_epu64_avx2(__m256i a, __m256i b)
+{
+    const __m256i sign = _mm256_set1_epi64x(INT64_MIN);
+    return _mm256_cmpgt_epi64(_mm256_xor_si256(a, sign), _mm256_xor_si256(b, sign));
+}
+
+__attribute__((target("avx2")))
+static inline void mul_wide_avx2(__m256i a, __m256i b, __m256i &lo, __m256i &hi)
+{
+    const __m256i mask_32 = _mm256_set1_epi64x(0xffffffff);
+    __m256i a_hi = _mm256_srli_epi64(a, 32);
+    __m256i b_hi = _mm256_srli_epi64(b, 32);
+
+    __m256i p00 = _mm256_mul_epu32(a, b);
+    __m256i p01 = _mm256_mul_epu32(a, b_hi);
+    __m256i p10 = _mm256_mul_epu32(a_hi, b);
+    __m256i p11 = _mm256_mul_epu32(a_hi, b_hi);
+
+    __m256i mid = _mm256_add_epi64(
+        _mm256_srli_epi64(p00, 32),
+        _mm256_add_epi64(_mm256_and_si256(p01, mask_32), _mm256_and_si256(p10, mask_32))
+    );
+
+    lo = _mm256_or_si256(_mm256_slli_epi64(mid, 32), _mm256_and_si256(p00, mask_32));
+    hi = _mm256_add_epi64(
+        _mm256_add_epi64(p11, _mm256_srli_epi64(mid, 32)),
+        _mm256_add_epi64(_mm256_srli_epi64(p01, 32), _mm256_srli_epi64(p10, 32))
+    );
+}
+
+__attribute__((target("avx2")))
+static inline __m256i mul_lo_avx2(__m256i a, __m256i b)
+{
+    __m256i p00 = _mm256_mul_epu32(a, b);
+    __m256i p01 = _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32));
+    __m256i p10 = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b);
+
+    return _mm256_add_epi64(p00, _mm256_slli_epi64(_mm256_add_epi64(p01, p10), 32));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i mont_mul_avx2(__m256i a, __m256i b, __m256i n, __m256i n_inv)
+{
+    __m256i t_lo, t_hi, mn_lo, mn_hi;
+    mul_wide_avx2(a, b, t_lo, t_hi);
+    mul_wide_avx2(mul_lo_avx2(t_lo, n_inv), n, mn_lo, mn_hi);
+
+    __m256i res = _mm256_sub_epi64(t_hi, mn_hi);
+    __m256i borrow = cmpgt_epu64_avx2(mn_hi, t_hi);
+
+    return _mm256_add_epi64(res, _mm256_and_si256(borrow, n));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i mont_double_avx2(__m256i a, __m256i n)
+{
+    __m256i sum = _mm256_add_epi64(a, a);
+    __m256i wrap = _mm256_or_si256(
+        cmpgt_epu64_avx2(a, sum),
+        _mm256_xor_si256(cmpgt_epu64_avx2(n, sum), _mm256_set1_epi64x(-1))
+    );
+
+    return _mm256_sub_epi64(sum, _mm256_and_si256(wrap, n));
+}
+
+__attribute__((target("avx2")))
+static void strong_base2_avx2(const uint64_t *nums, uint8_t *pass)
+{
+    LaneSetup setup;
+    lane_setup(nums, setup);
+
+    for (uint32_t half = 0; half < SIMD_LANES; half += 4)
+    {
+        const __m256i n = _mm256_loadu_si256((const __m256i *)(nums + half));
+        const __m256i n_inv = _mm256_loadu_si256((const __m256i *)(setup.n_inv + half));
+        const __m256i one = _mm256_loadu_si256((const __m256i *)(setup.one + half));
+        const __m256i d = _mm256_loadu_si256((const __m256i *)(setup.d + half));
+        const __m256i s = _mm256_loadu_si256((const __m256i *)(setup.s + half));
+        const __m256i minus_one = _mm256_sub_epi64(n, one);
+
+        __m256i x = one;
+
+        for (int32_t bit = 63 - __builtin_clzll(setup.max_d); bit >= 0; bit--)
+        {
+            x = mont_mul_avx2(x, x, n, n_inv);
+
+            const __m256i bit_mask = _mm256_set1_epi64x(uint64_t(1) << bit);
+            __m256i set = _mm256_cmpeq_epi64(_mm256_and_si256(d, bit_mask), bit_mask);
+            x = _mm256_blendv_epi8(x, mont_double_avx2(x, n), set);
+        }
+
+        __m256i ok = _mm256_or_si256(_mm256_cmpeq_epi64(x, one), _mm256_cmpeq_epi64(x, minus_one));
+
+        for (uint64_t r = 1; r < setup.max_s; r++)
+        {
+            x = mont_mul_avx2(x, x, n, n_inv);
+
+            __m256i live = _mm256_cmpgt_epi64(s, _mm256_set1_epi64x(r));
+            ok = _mm256_or_si256(ok, _mm256_and_si256(live, _mm256_cmpeq_epi64(x, minus_one)));
+        }
+
+        uint32_t bits = _mm256_movemask_pd(_mm256_castsi256_pd(ok));
+        for (uint32_t i = 0; i < 4; i++)
+            pass[half + i] = (bits >> i) & 1;
+    }
+}
+
+static StrongBase2Kernel strong_base2_kernel(const char **name = nullptr)
+{
+    static const char *kernel_name = nullptr;
+    static const StrongBase2Kernel kernel = []() -> StrongBase2Kernel {
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx512f"))
+        {
+            kernel_name = "avx512";
+            return strong_base2_avx512;
+        }
+        if (__builtin_cpu_supports("avx2"))
+        {
+            kernel_name = "avx2";
+            return strong_base2_avx2;
+        }
+
+        kernel_name = "scalar";
+        return nullptr;
+    }();
+
+    if (name)
+        *name = kernel_name;
+
+    return kernel;
+}
+
+#endif
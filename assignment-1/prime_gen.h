@@ -0,0 +1,129 @@
+#ifndef PRIME_GEN_H
+#define PRIME_GEN_H
+
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include "small_primes.h"
+
+/*
+xoshiro256** seeded through splitmix64: a small, fast generator whose whole
+stream is fixed by one 64-bit seed, so a run can be reproduced exactly.
+*/
+
+class Xoshiro256
+{
+    private:
+        uint64_t state[4];
+
+    public:
+        Xoshiro256(uint64_t);
+        uint64_t operator()(void);
+};
+
+static uint64_t splitmix64(uint64_t &x)
+{
+    uint64_t z = (x += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+
+    return z ^ (z >> 31);
+}
+
+static uint64_t rotl(uint64_t x, uint32_t k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+Xoshiro256::Xoshiro256(uint64_t seed)
+{
+    for (uint64_t &word: this->state)
+        word = splitmix64(seed);
+}
+
+uint64_t Xoshiro256::operator()(void)
+{
+    const uint64_t res = rotl(this->state[1] * 5, 7) * 9;
+    const uint64_t t = this->state[1] << 17;
+
+    this->state[2] ^= this->state[0];
+    this->state[3] ^= this->state[1];
+    this->state[1] ^= this->state[2];
+    this->state[0] ^= this->state[3];
+    this->state[2] ^= t;
+    this->state[3] = rotl(this->state[3], 45);
+
+    return res;
+}
+
+/*
+draws random primes of exactly `bits` bits. a random odd start is drawn and a
+window of WINDOW_ODDS odd numbers after it is sieved with the small-prime
+table; the survivors are handed to the verify callback in increasing order
+and the first one it accepts is returned. short inputs (where the window
+would cover most of the range) are sampled and tested directly instead.
+*/
+
+const uint64_t WINDOW_ODDS = 4096;
+
+class PrimeGenerator
+{
+    private:
+        std::vector<uint8_t> window;
+
+    public:
+        const uint32_t bits;
+
+        PrimeGenerator(uint32_t);
+
+        template <typename Verify>
+        uint64_t next(Xoshiro256 &, Verify);
+};
+
+PrimeGenerator::PrimeGenerator(uint32_t bits)
+    : window(WINDOW_ODDS), bits(bits) {}
+
+template <typename Verify>
+uint64_t PrimeGenerator::next(Xoshiro256 &random, Verify verify)
+{
+    const uint64_t top = uint64_t(1) << (this->bits - 1);
+    const uint64_t max = top | (top - 1); // largest value with `bits` bits
+
+    while (true)
+    {
+        uint64_t start = (random() & max) | top;
+
+        if (this->bits <= 16)
+        {
+            if (verify(start))
+                return start;
+
+            continue;
+        }
+
+        start |= 1;
+        const uint64_t n_odds = std::min(WINDOW_ODDS, ((max - start) >> 1) + 1);
+        uint8_t *sieve = this->window.data();
+
+        std::fill(sieve, sieve + n_odds, 1);
+
+        // start + 2j = 0 (mod p)  <=>  j = (p - start mod p) * 2^-1 (mod p)
+        auto cross_off = [&](uint64_t p) {
+            uint64_t j = ((p - start % p) % p) * ((p + 1) >> 1) % p;
+            for (; j < n_odds; j += p)
+                sieve[j] = 0;
+        };
+
+        cross_off(3);
+        cross_off(5);
+        cross_off(7);
+        for (const SmallPrime &sp: SMALL_PRIMES)
+            cross_off(sp.p);
+
+        for (uint64_t j = 0; j < n_odds; j++)
+            if (sieve[j] and verify(start + (j << 1)))
+                return start + (j << 1);
+    }
+}
+
+#endif
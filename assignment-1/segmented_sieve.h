@@ -0,0 +1,202 @@
+#ifndef SEGMENTED_SIEVE_H
+#define SEGMENTED_SIEVE_H
+
+#include <cstdint>
+#include <cmath>
+#include <vector>
+
+/*
+segmented sieve of eratosthenes over an interval [lo, hi] of the 64-bit range.
+
+only odd numbers are stored, one bit each, in segments of SEGMENT_BYTES so a
+segment stays in the L1 cache while it is crossed off. segments are grouped
+into blocks; a block is the unit of parallel work and carries the next
+multiple of every base prime from one segment to the next, so the starting
+offsets (one division per prime) are computed once per block.
+
+base primes are kept up to BASE_LIMIT. when sqrt(hi) is larger than that (hi
+close to 2^64) the sieve leaves composites whose factors are all above
+BASE_LIMIT, and every survivor above BASE_LIMIT^2 has to be confirmed by the
+verify callback passed to sieve_block.
+*/
+
+const uint64_t SEGMENT_BYTES = 1 << 15;
+const uint64_t SEGMENT_BITS = SEGMENT_BYTES << 3;
+const uint64_t SEGMENTS_PER_BLOCK = 16;
+const uint64_t BLOCK_BITS = SEGMENT_BITS * SEGMENTS_PER_BLOCK;
+const uint64_t BASE_LIMIT = 1 << 24;
+
+class SegmentedSieve
+{
+    private:
+        std::vector<uint32_t> base_primes;
+        uint64_t first_odd;
+        uint64_t n_odds;
+
+    public:
+        const uint64_t lo, hi;
+        uint64_t verify_above; // survivors above this need verification
+
+        // per-worker buffers, reused across blocks
+        struct Scratch
+        {
+            std::vector<uint64_t> bits;
+            std::vector<uint64_t> next;
+        };
+
+        SegmentedSieve(uint64_t, uint64_t);
+
+        bool has_two(void) const;
+        uint64_t n_blocks(void) const;
+
+        template <typename Verify>
+        uint64_t sieve_block(uint64_t, Scratch &, std::vector<uint64_t> *, Verify) const;
+};
+
+static uint64_t isqrt(uint64_t n)
+{
+    uint64_t root = static_cast<uint64_t>(std::sqrt(static_cast<long double>(n)));
+
+    while ((root > 0) and (static_cast<unsigned __int128>(root) * root > n))
+        root--;
+    while (static_cast<unsigned __int128>(root + 1) * (root + 1) <= n)
+        root++;
+
+    return root;
+}
+
+SegmentedSieve::SegmentedSieve(uint64_t lo, uint64_t hi)
+    : lo(lo), hi(hi)
+{
+    uint64_t limit = std::min(isqrt(hi), BASE_LIMIT);
+    this->verify_above = (limit < isqrt(hi)) ? limit * limit : UINT64_MAX;
+
+    // simple odd-only sieve for the base primes themselves
+    std::vector<uint8_t> composite((limit >> 1) + 1, 0);
+    for (uint64_t p = 3; p * p <= limit; p += 2)
+    {
+        if (composite[p >> 1])
+            continue;
+
+        for (uint64_t m = p * p; m <= limit; m += p << 1)
+            composite[m >> 1] = 1;
+    }
+
+    for (uint64_t p = 3; p <= limit; p += 2)
+        if (!composite[p >> 1]) this->base_primes.push_back(p);
+
+    this->first_odd = lo | 1;
+    if (this->first_odd > hi)
+        this->n_odds = 0;
+    else
+        this->n_odds = ((hi - this->first_odd) >> 1) + 1;
+}
+
+bool SegmentedSieve::has_two(void) const
+{
+    return (this->lo <= 2) and (this->hi >= 2);
+}
+
+uint64_t SegmentedSieve::n_blocks(void) const
+{
+    return (this->n_odds + BLOCK_BITS - 1) / BLOCK_BITS;
+}
+
+/*
+sieve one block and return the number of primes in it, appending them in
+increasing order to primes when it is not null.
+*/
+
+template <typename Verify>
+uint64_t SegmentedSieve::sieve_block(uint64_t block, Scratch &scratch, std::vector<uint64_t> *primes, Verify verify) const
+{
+    const uint64_t begin = block * BLOCK_BITS;
+    const uint64_t end = std::min(begin + BLOCK_BITS, this->n_odds);
+    const uint64_t start = this->first_odd + (begin << 1);        // first odd in the block
+    const uint64_t last = this->first_odd + ((end - 1) << 1);     // last odd in the block
+
+    scratch.bits.resize(SEGMENT_BITS >> 6);
+    scratch.next.resize(this->base_primes.size());
+
+    // index (relative to the block) of the first odd multiple >= max(p^2, start)
+    uint64_t n_primes = 0;
+    for (const uint32_t &p: this->base_primes)
+    {
+        uint64_t p2 = static_cast<uint64_t>(p) * p;
+        if (p2 > last)
+            break;
+
+        unsigned __int128 first = p2;
+        if (p2 < start)
+        {
+            first = start + (p - start % p) % p;
+            if ((first & 1) == 0)
+                first += p;
+        }
+
+        scratch.next[n_primes++] = static_cast<uint64_t>((first - start) >> 1);
+    }
+
+    uint64_t count = 0;
+
+    for (uint64_t seg = 0; seg < end - begin; seg += SEGMENT_BITS)
+    {
+        const uint64_t seg_len = std::min(SEGMENT_BITS, end - begin - seg);
+        const uint64_t seg_end = seg + seg_len;
+        const uint64_t n_words = (seg_len + 63) >> 6;
+        uint64_t *bits = scratch.bits.data();
+
+        for (uint64_t w = 0; w < n_words; w++)
+            bits[w] = UINT64_MAX;
+        if (seg_len & 63)
+            bits[n_words - 1] = (uint64_t(1) << (seg_len & 63)) - 1;
+
+        for (uint64_t i = 0; i < n_primes; i++)
+        {
+            const uint64_t p = this->base_primes[i];
+            uint64_t j = scratch.next[i];
+
+            for (; j < seg_end; j += p)
+                bits[(j - seg) >> 6] &= ~(uint64_t(1) << ((j - seg) & 63));
+
+            scratch.next[i] = j;
+        }
+
+        const uint64_t seg_start = start + (seg << 1);
+
+        if (seg_start == 1)
+            bits[0] &= ~uint64_t(1);
+
+        const bool needs_verify = (seg_start + ((seg_len - 1) << 1)) > this->verify_above;
+
+        if ((primes == nullptr) and !needs_verify)
+        {
+            for (uint64_t w = 0; w < n_words; w++)
+                count += __builtin_popcountll(bits[w]);
+
+            continue;
+        }
+
+        for (uint64_t w = 0; w < n_words; w++)
+        {
+            uint64_t word = bits[w];
+
+            while (word)
+            {
+                uint64_t n = seg_start + ((((w << 6) | __builtin_ctzll(word))) << 1);
+                word &= word - 1;
+
+                if ((n > this->verify_above) and !verify(n))
+                    continue;
+
+                count++;
+                if (primes)
+                    primes->push_back(n);
+            }
+        }
+    }
+
+    return count;
+}
+
+#endif
@@ -0,0 +1,144 @@
+#ifndef SMALL_PRIMES_H
+#define SMALL_PRIMES_H
+
+#include <cstdint>
+#include <array>
+
+/*
+compile-time tables for the trial-division prefilter.
+
+WHEEL_210 marks the residues mod 2 * 3 * 5 * 7 that are coprime to 210, so a
+single remainder rejects every multiple of the first four primes.
+
+SMALL_PRIMES holds the primes 11 <= p < SMALL_PRIME_BOUND with p^-1 mod 2^64:
+for odd p, p divides n exactly when n * p^-1 mod 2^64 <= (2^64 - 1) / p, which
+tests divisibility with one multiplication instead of a division.
+
+SMALL_PRIME_GROUPS packs consecutive table entries into products below 2^64,
+so a multi-precision n needs one mpz remainder per group rather than per prime.
+*/
+
+struct SmallPrime
+{
+    uint64_t p;
+    uint64_t inv;
+    uint64_t lim;
+};
+
+struct SmallPrimeGroup
+{
+    uint64_t product;
+    uint32_t begin;
+    uint32_t end;
+};
+
+const uint32_t SMALL_PRIME_BOUND = 1024;
+
+constexpr bool is_small_prime(uint32_t n)
+{
+    if (n < 2)
+        return false;
+
+    for (uint32_t d = 2; d * d <= n; d++)
+        if (n % d == 0) return false;
+
+    return true;
+}
+
+constexpr uint32_t count_small_primes(void)
+{
+    uint32_t count = 0;
+    for (uint32_t n = 11; n < SMALL_PRIME_BOUND; n++)
+        count += is_small_prime(n);
+
+    return count;
+}
+
+constexpr uint64_t inverse_mod_2_64(uint64_t n)
+{
+    // newton iteration, each step doubles the number of correct low bits
+    uint64_t inv = n;
+    for (uint32_t i = 0; i < 5; i++)
+        inv *= 2 - n * inv;
+
+    return inv;
+}
+
+const uint32_t N_SMALL_PRIMES = count_small_primes();
+
+constexpr std::array<SmallPrime, N_SMALL_PRIMES> make_small_primes(void)
+{
+    std::array<SmallPrime, N_SMALL_PRIMES> primes {};
+    uint32_t idx = 0;
+
+    for (uint32_t n = 11; n < SMALL_PRIME_BOUND; n++)
+    {
+        if (!is_small_prime(n))
+            continue;
+
+        primes[idx].p = n;
+        primes[idx].inv = inverse_mod_2_64(n);
+        primes[idx].lim = UINT64_MAX / n;
+        idx++;
+    }
+
+    return primes;
+}
+
+constexpr std::array<bool, 210> make_wheel_210(void)
+{
+    std::array<bool, 210> wheel {};
+    for (uint32_t r = 0; r < 210; r++)
+        wheel[r] = (r % 2) and (r % 3) and (r % 5) and (r % 7);
+
+    return wheel;
+}
+
+constexpr std::array<SmallPrime, N_SMALL_PRIMES> SMALL_PRIMES = make_small_primes();
+constexpr std::array<bool, 210> WHEEL_210 = make_wheel_210();
+
+constexpr uint32_t count_small_prime_groups(void)
+{
+    uint32_t groups = 0;
+    unsigned __int128 product = 1;
+
+    for (uint32_t i = 0; i < N_SMALL_PRIMES; i++)
+    {
+        if (product * SMALL_PRIMES[i].p > UINT64_MAX)
+        {
+            groups++;
+            product = 1;
+        }
+        product *= SMALL_PRIMES[i].p;
+    }
+
+    return groups + 1;
+}
+
+const uint32_t N_SMALL_PRIME_GROUPS = count_small_prime_groups();
+
+constexpr std::array<SmallPrimeGroup, N_SMALL_PRIME_GROUPS> make_small_prime_groups(void)
+{
+    std::array<SmallPrimeGroup, N_SMALL_PRIME_GROUPS> groups {};
+    unsigned __int128 product = 1;
+    uint32_t idx = 0, begin = 0;
+
+    for (uint32_t i = 0; i < N_SMALL_PRIMES; i++)
+    {
+        if (product * SMALL_PRIMES[i].p > UINT64_MAX)
+        {
+            groups[idx++] = { static_cast<uint64_t>(product), begin, i };
+            product = 1;
+            begin = i;
+        }
+        product *= SMALL_PRIMES[i].p;
+    }
+
+    groups[idx] = { static_cast<uint64_t>(product), begin, N_SMALL_PRIMES };
+
+    return groups;
+}
+
+constexpr std::array<SmallPrimeGroup, N_SMALL_PRIME_GROUPS> SMALL_PRIME_GROUPS = make_small_prime_groups();
+
+#endif
@@ -1,123 +1,414 @@
 #include <iostream>
-#include <random>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include "solvay_strassen.h"
+#include "thread_pool.h"
+#include "segmented_sieve.h"
+#include "prime_gen.h"
 
-class SolvayStrassen
+static bool parse_u64(const char *str, uint64_t &num)
 {
-    private:
-        int64_t jacobi(int64_t, int64_t);
-        int64_t mod_exp(int64_t, int64_t, int64_t);
-    
-    public:
-        bool is_prime(int64_t, int64_t);
-};
-
-int64_t SolvayStrassen::jacobi(int64_t a, int64_t b)
+    if ((str == nullptr) or (*str == '\0') or (*str == '-'))
+        return false;
+
+    char *end;
+    errno = 0;
+    num = std::strtoull(str, &end, 10);
+
+    return (errno == 0) and (*end == '\0');
+}
+
+// "det" selects the deterministic 64-bit test, encoded as zero rounds
+static bool parse_iterations(const char *str, uint64_t &it)
+{
+    if (std::strcmp(str, "det") == 0)
+    {
+        it = 0;
+        return true;
+    }
+
+    return parse_u64(str, it) and (it > 0);
+}
+
+static void usage(const char *prog)
 {
-    if ((b <= 0) or (b % 2 == 0))
-        return 0;
+    std::cerr << "Usage: " << prog << " <number> <iterations>\n";
+    std::cerr << "       " << prog << " --batch <iterations> [file|-] [threads]\n";
+    std::cerr << "       " << prog << " --range <iterations> <a> <b> [threads] [--list]\n";
+    std::cerr << "       " << prog << " --gen <iterations> <bits> <count> <seed> <file> [threads]\n";
+    std::cerr << "<iterations> is a number of random rounds, or 'det' for the\n";
+    std::cerr << "deterministic baillie-psw test (64-bit inputs only)\n";
+}
+
+/*
+stream numbers (whitespace separated) from a file or stdin, test them on a
+pool of worker threads chunk by chunk and print the verdicts in input order.
+*/
 
-    int64_t jac = 1;
+static int batch(std::istream &in, uint64_t it, uint32_t n_threads)
+{
+    const uint64_t CHUNK_SIZE = 1 << 16;
+    const uint64_t TASK_SIZE = 1 << 10;
 
-    if (a < 0)
+    ThreadPool pool(n_threads);
+    std::vector<std::mt19937_64> randoms;
     {
-        a = -a;
-        if (b % 4 == 3)
-            jac = -jac;
+        std::random_device random;
+        for (uint32_t i = 0; i < pool.size; i++)
+            randoms.emplace_back(random());
     }
 
-    while (a != 0)
+    const SolvayStrassen ss;
+    std::vector<uint64_t> nums;
+    std::vector<uint8_t> primes;
+    std::string token, out;
+    uint64_t n, total = 0;
+    bool eof = false;
+
+    auto start = std::chrono::steady_clock::now();
+
+    while (!eof)
     {
-        while (a % 2 == 0)
+        nums.clear();
+
+        while (nums.size() < CHUNK_SIZE)
         {
-            a >>= 1;
-            if (
-                (b % 8 == 3) or
-                (b % 8 == 5)
-            ) jac = -jac;
+            if (!(in >> token))
+            {
+                eof = true;
+                break;
+            }
+
+            if (parse_u64(token.c_str(), n))
+                nums.push_back(n);
+            else
+                std::cerr << "skipping invalid number '" << token << "'\n";
         }
 
-        std::swap(a, b);
+        primes.assign(nums.size(), 0);
+
+        pool.run((nums.size() + TASK_SIZE - 1) / TASK_SIZE, [&](uint32_t id, uint64_t task) {
+            uint64_t begin = task * TASK_SIZE;
+            uint64_t stop = std::min(begin + TASK_SIZE, static_cast<uint64_t>(nums.size()));
+
+            if (it == 0)
+            {
+                ss.is_prime_batch(&nums[begin], &primes[begin], stop - begin);
+                return;
+            }
 
-        if (
-            (a % 4 == 3) and
-            (b % 4 == 3)
-        ) jac = -jac;
+            for (uint64_t i = begin; i < stop; i++)
+                primes[i] = ss.is_prime(nums[i], it, randoms[id]);
+        });
 
-        a = a % b;
+        out.clear();
+        for (uint64_t i = 0; i < nums.size(); i++)
+        {
+            out += std::to_string(nums[i]);
+            out += primes[i] ? " prime\n" : " composite\n";
+        }
+
+        std::cout << out;
+        total += nums.size();
     }
 
-    if (b == 1)
-        return jac;
-    
+    std::cout.flush();
+
+    auto stop = std::chrono::steady_clock::now();
+    double secs = std::chrono::duration<double>(stop - start).count();
+
+    std::cerr << "tested " << total << " numbers in " << secs << " s on ";
+    std::cerr << pool.size << " threads (" << (secs > 0 ? total / secs : 0.0);
+    std::cerr << " numbers/sec)\n";
+
     return 0;
 }
 
-int64_t SolvayStrassen::mod_exp(int64_t a, int64_t b, int64_t c)
+/*
+count (or list, in increasing order) the primes in [a, b] with a segmented
+sieve whose blocks are spread over the pool. solovay-strassen only runs on
+survivors too large for the base primes to certify, i.e. close to 2^64.
+*/
+
+static int range(uint64_t a, uint64_t b, uint64_t it, uint32_t n_threads, bool list)
 {
-    int64_t res = 1;
+    auto start = std::chrono::steady_clock::now();
 
-    while (b--)
+    ThreadPool pool(n_threads);
+    const SegmentedSieve sieve(a, b);
+    const SolvayStrassen ss;
+
+    std::vector<SegmentedSieve::Scratch> scratch(pool.size);
+    std::vector<std::mt19937_64> randoms;
     {
-        res *= a;
-        res %= c;
+        std::random_device random;
+        for (uint32_t i = 0; i < pool.size; i++)
+            randoms.emplace_back(random());
+    }
+
+    // blocks are listed in waves so memory stays bounded for huge ranges
+    const uint64_t WAVE_SIZE = list ? 4 * pool.size : sieve.n_blocks();
+    std::vector<std::vector<uint64_t>> primes(list ? WAVE_SIZE : 0);
+    std::vector<uint64_t> counts(WAVE_SIZE);
+    uint64_t total = sieve.has_two() ? 1 : 0;
+    std::string out;
+
+    if (list and sieve.has_two())
+        std::cout << "2\n";
+
+    for (uint64_t wave = 0; wave < sieve.n_blocks(); wave += WAVE_SIZE)
+    {
+        uint64_t n_tasks = std::min(WAVE_SIZE, sieve.n_blocks() - wave);
+
+        pool.run(n_tasks, [&](uint32_t id, uint64_t task) {
+            std::vector<uint64_t> *block_primes = nullptr;
+            if (list)
+            {
+                block_primes = &primes[task];
+                block_primes->clear();
+            }
+
+            counts[task] = sieve.sieve_block(wave + task, scratch[id], block_primes, [&](uint64_t n) {
+                return it ? ss.is_prime(n, it, randoms[id]) : ss.is_prime(n);
+            });
+        });
+
+        for (uint64_t task = 0; task < n_tasks; task++)
+        {
+            total += counts[task];
+            if (!list)
+                continue;
+
+            out.clear();
+            for (const uint64_t &p: primes[task])
+            {
+                out += std::to_string(p);
+                out += '\n';
+            }
+            std::cout << out;
+        }
     }
 
-    return res % c;
+    if (!list)
+        std::cout << total << " primes in [" << a << ", " << b << "]\n";
+
+    std::cout.flush();
+
+    auto stop = std::chrono::steady_clock::now();
+    double secs = std::chrono::duration<double>(stop - start).count();
+    double width = static_cast<double>(b - a) + 1.0;
+
+    std::cerr << "sieved " << width << " numbers in " << secs << " s on ";
+    std::cerr << pool.size << " threads (" << (secs > 0 ? width / secs : 0.0);
+    std::cerr << " numbers/sec, " << total << " primes)\n";
+
+    return 0;
 }
 
-bool SolvayStrassen::is_prime(int64_t n, int64_t it)
+/*
+write `count` random primes of exactly `bits` bits to `path` as raw
+little-endian uint64 values. the primes are produced in tasks of TASK_SIZE,
+and task t always draws from a generator seeded with (seed, t), so the file
+only depends on the seed and not on the number of threads.
+*/
+
+static int generate(uint64_t it, uint32_t bits, uint64_t count, uint64_t seed, const char *path, uint32_t n_threads)
 {
-    if (n < 2)
-        return false;
-    if (n == 2)
-        return true;
-    if (n % 2 == 0)
-        return false;
-    
-    int64_t rand, a, jacobian, mod;
-    std::random_device random;
+    const uint64_t TASK_SIZE = 1 << 12;
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cerr << "cannot open " << path << "\n";
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    ThreadPool pool(n_threads);
+    const SolvayStrassen ss;
+    std::vector<PrimeGenerator> generators(pool.size, PrimeGenerator(bits));
+
+    const uint64_t n_tasks = (count + TASK_SIZE - 1) / TASK_SIZE;
+    const uint64_t WAVE_SIZE = 4 * pool.size;
+    std::vector<uint64_t> primes;
 
-    while (it--)
+    for (uint64_t wave = 0; wave < n_tasks; wave += WAVE_SIZE)
     {
-        rand = abs(static_cast<int64_t>(random()));
-        a = (rand % (n - 1)) + 1;
-        jacobian = (n + this->jacobi(a, n)) % n;
-        mod = this->mod_exp(a, (n - 1) >> 1, n);
-
-        if (
-            (jacobian == 0) or
-            (mod != jacobian)
-        ) return false;
+        const uint64_t first = wave * TASK_SIZE;
+        const uint64_t last = std::min(count, (wave + WAVE_SIZE) * TASK_SIZE);
+        primes.resize(last - first);
+
+        pool.run(std::min(WAVE_SIZE, n_tasks - wave), [&](uint32_t id, uint64_t task) {
+            uint64_t task_seed = seed ^ ((wave + task) * 0xd1b54a32d192ed03);
+            Xoshiro256 random(task_seed);
+            std::mt19937_64 round_random(random());
+
+            uint64_t begin = task * TASK_SIZE;
+            uint64_t stop = std::min(begin + TASK_SIZE, last - first);
+
+            for (uint64_t i = begin; i < stop; i++)
+            {
+                primes[i] = generators[id].next(random, [&](uint64_t n) {
+                    return it ? ss.is_prime(n, it, round_random) : ss.is_prime(n);
+                });
+            }
+        });
+
+        for (const uint64_t &p: primes)
+        {
+            uint8_t bytes[8];
+            for (uint32_t i = 0; i < 8; i++)
+                bytes[i] = (p >> (i << 3)) & 0xff;
+
+            file.write(reinterpret_cast<const char *>(bytes), sizeof(bytes));
+        }
     }
 
-    return true;
+    file.close();
+    if (!file)
+    {
+        std::cerr << "failed writing " << path << "\n";
+        return 1;
+    }
+
+    auto stop = std::chrono::steady_clock::now();
+    double secs = std::chrono::duration<double>(stop - start).count();
+
+    std::cerr << "generated " << count << " " << bits << "-bit primes in " << secs;
+    std::cerr << " s on " << pool.size << " threads (" << (secs > 0 ? count / secs : 0.0);
+    std::cerr << " primes/sec)\n";
+
+    return 0;
 }
 
 int main(int argc, char *argv[])
 {
     if (argc < 3)
     {
-        std::cerr << "Usage: " << argv[0] << " <number> <iterations>\n";
+        usage(argv[0]);
         return 1;
     }
 
-    int64_t n = atoi(argv[1]);
-    if (n < 0)
+    uint64_t it;
+    if (!parse_iterations(argv[2], it))
+    {
+        std::cerr << "<iterations> should be positive or 'det'\n";
+        return 1;
+    }
+
+    if (std::strcmp(argv[1], "--batch") == 0)
+    {
+        uint64_t n_threads = std::thread::hardware_concurrency();
+        if ((argc > 4) and (!parse_u64(argv[4], n_threads) or (n_threads == 0)))
+        {
+            std::cerr << "[threads] should be positive\n";
+            return 1;
+        }
+
+        std::ios::sync_with_stdio(false);
+
+        if ((argc < 4) or (std::strcmp(argv[3], "-") == 0))
+            return batch(std::cin, it, n_threads);
+
+        std::ifstream file(argv[3]);
+        if (!file)
+        {
+            std::cerr << "cannot open " << argv[3] << "\n";
+            return 1;
+        }
+
+        return batch(file, it, n_threads);
+    }
+
+    if (std::strcmp(argv[1], "--range") == 0)
+    {
+        uint64_t a, b;
+        if ((argc < 5) or !parse_u64(argv[3], a) or !parse_u64(argv[4], b) or (a > b))
+        {
+            std::cerr << "<a> and <b> should be 64-bit integers with a <= b\n";
+            return 1;
+        }
+
+        uint64_t n_threads = std::thread::hardware_concurrency();
+        bool list = false;
+
+        for (int32_t i = 5; i < argc; i++)
+        {
+            if (std::strcmp(argv[i], "--list") == 0)
+                list = true;
+            else if (!parse_u64(argv[i], n_threads) or (n_threads == 0))
+            {
+                std::cerr << "[threads] should be positive\n";
+                return 1;
+            }
+        }
+
+        std::ios::sync_with_stdio(false);
+
+        return range(a, b, it, n_threads, list);
+    }
+
+    if (std::strcmp(argv[1], "--gen") == 0)
+    {
+        uint64_t bits, count, seed;
+        if ((argc < 7) or !parse_u64(argv[3], bits) or (bits < 2) or (bits > 64))
+        {
+            std::cerr << "<bits> should be between 2 and 64\n";
+            return 1;
+        }
+        if (!parse_u64(argv[4], count) or (count == 0))
+        {
+            std::cerr << "<count> should be positive\n";
+            return 1;
+        }
+        if (!parse_u64(argv[5], seed))
+        {
+            std::cerr << "<seed> should be a non-negative 64-bit integer\n";
+            return 1;
+        }
+
+        uint64_t n_threads = std::thread::hardware_concurrency();
+        if ((argc > 7) and (!parse_u64(argv[7], n_threads) or (n_threads == 0)))
+        {
+            std::cerr << "[threads] should be positive\n";
+            return 1;
+        }
+
+        return generate(it, bits, count, seed, argv[6], n_threads);
+    }
+
+    // numbers of any size go through the gmp engine, which hands anything
+    // that fits in 64 bits back to the montgomery path
+    mpz_t n; mpz_init(n);
+    if ((argv[1][0] == '-') or (mpz_set_str(n, argv[1], 10) != 0))
     {
-        std::cerr << "<number> should be non-negative\n";
+        std::cerr << "<number> should be a non-negative integer\n";
+        mpz_clear(n);
         return 1;
     }
 
-    int64_t it = atoi(argv[2]);
-    if (it <= 0)
+    if ((it == 0) and (mpz_sizeinbase(n, 2) > 64))
     {
-        std::cerr << "<iterations> should be positive\n";
+        std::cerr << "'det' only covers numbers below 2^64\n";
+        mpz_clear(n);
         return 1;
     }
 
-    SolvayStrassen().is_prime(n, it)
-        ? std::cout << n << " is a prime number\n"
-        : std::cout << n << " is not a prime number\n";
-    
+    char *n_str = mpz_get_str(nullptr, 10, n);
+    SolvayStrassen ss;
+
+    (it ? ss.is_prime(n, it) : ss.is_prime(static_cast<uint64_t>(mpz_get_ui(n))))
+        ? std::cout << n_str << " is a prime number\n"
+        : std::cout << n_str << " is not a prime number\n";
+
+    std::free(n_str);
+    mpz_clear(n);
+
     return 0;
 }
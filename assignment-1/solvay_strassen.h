@@ -0,0 +1,626 @@
+#ifndef SOLVAY_STRASSEN_H
+#define SOLVAY_STRASSEN_H
+
+#include <cstdint>
+#include <random>
+#include <utility>
+#include <cmath>
+#include <gmp.h>
+#include "small_primes.h"
+#include "mont_simd.h"
+
+/*
+montgomery arithmetic modulo an odd 64-bit n with R = 2^64. residues are kept
+in montgomery form (x * R mod n) so that a modular multiplication costs three
+64x64->128 bit multiplications and no division.
+*/
+
+class Montgomery
+{
+    private:
+        uint64_t reduce(unsigned __int128) const;
+
+    public:
+        const uint64_t n;
+        const uint64_t n_inv; // n^-1 mod 2^64
+        const uint64_t r2;    // R^2 mod n
+        const uint64_t one;   // R mod n
+
+        Montgomery(uint64_t);
+        uint64_t to_mont(uint64_t) const;
+        uint64_t from_mont(uint64_t) const;
+        uint64_t add(uint64_t, uint64_t) const;
+        uint64_t sub(uint64_t, uint64_t) const;
+        uint64_t half(uint64_t) const;
+        uint64_t mul(uint64_t, uint64_t) const;
+        uint64_t pow(uint64_t, uint64_t) const;
+};
+
+// trial divisors tried on 64-bit inputs, past this the exponentiation is cheaper
+const uint32_t U64_TRIAL_PRIMES = 32;
+
+/*
+the mpz_t overloads keep their temporaries in per-object scratch values so the
+rounds of a test do not allocate; use one SolvayStrassen object per thread.
+*/
+
+class SolvayStrassen
+{
+    private:
+        mpz_t mp_a;
+        mpz_t mp_e;
+        mpz_t mp_mod;
+        mpz_t mp_n_1;
+        mpz_t mp_x;
+        mpz_t mp_y;
+        gmp_randstate_t mp_random;
+
+        int64_t jacobi(const mpz_t &, const mpz_t &);
+        uint64_t mul_mod(uint64_t, uint64_t, uint64_t) const;
+        bool strong_lucas_test(const Montgomery &) const;
+
+    public:
+        enum Prefilter
+        {
+            COMPOSITE = 0,
+            PRIME = 1,
+            UNDECIDED = 2
+        };
+
+        SolvayStrassen(void);
+        SolvayStrassen(const SolvayStrassen &) = delete;
+        SolvayStrassen & operator=(const SolvayStrassen &) = delete;
+        ~SolvayStrassen();
+
+        int64_t jacobi(uint64_t, uint64_t) const;
+        uint64_t mod_exp(uint64_t, uint64_t, uint64_t) const;
+        Prefilter prefilter(uint64_t) const;
+        Prefilter prefilter(const mpz_t &) const;
+        bool euler_test(uint64_t, uint64_t, std::mt19937_64 &) const;
+        bool strong_test(const Montgomery &, uint64_t) const;
+        bool is_prime(uint64_t) const;
+        void is_prime_batch(const uint64_t *, uint8_t *, uint64_t) const;
+        bool is_prime(uint64_t, uint64_t) const;
+        bool is_prime(uint64_t, uint64_t, std::mt19937_64 &) const;
+        bool is_prime(const mpz_t &, uint64_t);
+};
+
+Montgomery::Montgomery(uint64_t n)
+    : n(n), n_inv(inverse_mod_2_64(n)),
+      r2(static_cast<uint64_t>(
+          (static_cast<unsigned __int128>((0 - n) % n) * ((0 - n) % n)) % n
+      )), one((0 - n) % n) {}
+
+uint64_t Montgomery::reduce(unsigned __int128 t) const
+{
+    // t / R mod n, for any t < n * R
+    uint64_t t_lo = static_cast<uint64_t>(t);
+    uint64_t t_hi = static_cast<uint64_t>(t >> 64);
+
+    uint64_t m = t_lo * this->n_inv;
+    uint64_t mn_hi = static_cast<uint64_t>(
+        (static_cast<unsigned __int128>(m) * this->n) >> 64
+    );
+
+    uint64_t res = t_hi - mn_hi;
+    if (t_hi < mn_hi)
+        res += this->n;
+
+    return res;
+}
+
+uint64_t Montgomery::to_mont(uint64_t a) const
+{
+    return this->mul(a % this->n, this->r2);
+}
+
+uint64_t Montgomery::from_mont(uint64_t a) const
+{
+    return this->reduce(a);
+}
+
+uint64_t Montgomery::add(uint64_t a, uint64_t b) const
+{
+    uint64_t sum = a + b;
+    if ((sum < a) or (sum >= this->n))
+        sum -= this->n;
+
+    return sum;
+}
+
+uint64_t Montgomery::sub(uint64_t a, uint64_t b) const
+{
+    return (a >= b) ? a - b : a - b + this->n;
+}
+
+uint64_t Montgomery::half(uint64_t a) const
+{
+    // (a + n) / 2 for odd a, written so that it cannot overflow
+    return (a & 1) ? (a >> 1) + (this->n >> 1) + 1 : a >> 1;
+}
+
+uint64_t Montgomery::mul(uint64_t a, uint64_t b) const
+{
+    return this->reduce(static_cast<unsigned __int128>(a) * b);
+}
+
+uint64_t Montgomery::pow(uint64_t a, uint64_t b) const
+{
+    // left-to-right square-and-multiply over montgomery residues
+    uint64_t res = this->one;
+
+    for (int32_t bit = 63 - __builtin_clzll(b | 1); bit >= 0; bit--)
+    {
+        res = this->mul(res, res);
+        if ((b >> bit) & 1)
+            res = this->mul(res, a);
+    }
+
+    return res;
+}
+
+SolvayStrassen::SolvayStrassen(void)
+{
+    mpz_init(this->mp_a);
+    mpz_init(this->mp_e);
+    mpz_init(this->mp_mod);
+    mpz_init(this->mp_n_1);
+    mpz_init(this->mp_x);
+    mpz_init(this->mp_y);
+
+    gmp_randinit_default(this->mp_random);
+    gmp_randseed_ui(this->mp_random, std::random_device{}());
+}
+
+SolvayStrassen::~SolvayStrassen()
+{
+    mpz_clear(this->mp_a);
+    mpz_clear(this->mp_e);
+    mpz_clear(this->mp_mod);
+    mpz_clear(this->mp_n_1);
+    mpz_clear(this->mp_x);
+    mpz_clear(this->mp_y);
+
+    gmp_randclear(this->mp_random);
+}
+
+int64_t SolvayStrassen::jacobi(uint64_t a, uint64_t b) const
+{
+    if ((b == 0) or (b % 2 == 0))
+        return 0;
+
+    /*
+    binary jacobi: all factors of two go in one shift, and the sign is kept
+    in bit 1 of sign. (2 / b) = -1 iff b = 3, 5 (mod 8), i.e. bit 1 of
+    b ^ (b >> 1) is set; reciprocity flips the sign iff a = b = 3 (mod 4),
+    i.e. bit 1 of a & b is set. subtraction replaces the division.
+    */
+
+    uint64_t sign = 0, diff, swap;
+    uint32_t zeros;
+
+    while (a != 0)
+    {
+        zeros = __builtin_ctzll(a);
+        a >>= zeros;
+        sign ^= (zeros << 1) & (b ^ (b >> 1));
+
+        // (a, b) <- (|a - b|, min(a, b)) with masks instead of a branch
+        diff = a - b;
+        swap = 0 - static_cast<uint64_t>(a < b);
+        sign ^= a & b & swap;
+        b += diff & swap;
+        a = (diff ^ swap) - swap;
+    }
+
+    if (b == 1)
+        return 1 - static_cast<int64_t>(sign & 2);
+
+    return 0;
+}
+
+int64_t SolvayStrassen::jacobi(const mpz_t &a, const mpz_t &b)
+{
+    // binary jacobi: strip every factor of two in one shift, read the
+    // residues mod 4 and mod 8 straight off the lowest limb
+    if (mpz_even_p(b))
+        return 0;
+
+    mpz_t &x = this->mp_x, &y = this->mp_y;
+    mpz_mod(x, a, b);
+    mpz_set(y, b);
+
+    int64_t jac = 1;
+    mp_bitcnt_t zeros;
+    mp_limb_t y_lo;
+
+    while (mpz_sgn(x) != 0)
+    {
+        zeros = mpz_scan1(x, 0);
+        y_lo = mpz_getlimbn(y, 0);
+
+        if (zeros)
+        {
+            mpz_tdiv_q_2exp(x, x, zeros);
+            if ((zeros & 1) and (((y_lo & 7) == 3) or ((y_lo & 7) == 5)))
+                jac = -jac;
+        }
+
+        if (((mpz_getlimbn(x, 0) & 3) == 3) and ((y_lo & 3) == 3))
+            jac = -jac;
+
+        mpz_swap(x, y);
+        mpz_tdiv_r(x, x, y);
+    }
+
+    if (mpz_cmp_ui(y, 1) == 0)
+        return jac;
+
+    return 0;
+}
+
+uint64_t SolvayStrassen::mul_mod(uint64_t a, uint64_t b, uint64_t c) const
+{
+    return static_cast<uint64_t>((static_cast<unsigned __int128>(a) * b) % c);
+}
+
+uint64_t SolvayStrassen::mod_exp(uint64_t a, uint64_t b, uint64_t c) const
+{
+    if (c == 1)
+        return 0;
+
+    if (c % 2 == 1)
+    {
+        const Montgomery mont(c);
+        return mont.from_mont(mont.pow(mont.to_mont(a), b));
+    }
+
+    // even moduli have no montgomery form, fall back to 128-bit remainders
+    uint64_t res = 1;
+    a %= c;
+
+    while (b)
+    {
+        if (b & 1)
+            res = this->mul_mod(res, a, c);
+
+        a = this->mul_mod(a, a, c);
+        b >>= 1;
+    }
+
+    return res;
+}
+
+/*
+strong form of euler's criterion: with n - 1 = d * 2^s, d odd, n is a strong
+probable prime to base a if a^d = 1 or a^(d * 2^r) = -1 for some r < s.
+every strong probable prime is also an euler (solovay-strassen) one.
+*/
+
+bool SolvayStrassen::strong_test(const Montgomery &mont, uint64_t base) const
+{
+    const uint64_t n = mont.n;
+    const uint64_t minus_one = n - mont.one;
+    const uint32_t s = __builtin_ctzll(n - 1);
+
+    uint64_t x = mont.pow(mont.to_mont(base), (n - 1) >> s);
+
+    if ((x == mont.one) or (x == minus_one))
+        return true;
+
+    for (uint32_t r = 1; r < s; r++)
+    {
+        x = mont.mul(x, x);
+        if (x == minus_one)
+            return true;
+    }
+
+    return false;
+}
+
+static bool is_square(uint64_t n)
+{
+    uint64_t root = static_cast<uint64_t>(std::sqrt(static_cast<double>(n)));
+
+    while ((root > 0) and (static_cast<unsigned __int128>(root) * root > n))
+        root--;
+    while (static_cast<unsigned __int128>(root + 1) * (root + 1) <= n)
+        root++;
+
+    return root * root == n;
+}
+
+/*
+strong lucas probable prime test with selfridge's parameters: D is the first
+of 5, -7, 9, -11, ... with (D / n) = -1, P = 1 and Q = (1 - D) / 4. with
+n + 1 = d * 2^s, d odd, n passes if U_d = 0 or V_(d * 2^r) = 0 for some r < s.
+*/
+
+bool SolvayStrassen::strong_lucas_test(const Montgomery &mont) const
+{
+    const uint64_t n = mont.n;
+    int64_t d_sel = 5;
+
+    while (true)
+    {
+        uint64_t abs_d = (d_sel < 0) ? -d_sel : d_sel;
+        uint64_t d_mod = abs_d % n;
+        if (d_sel < 0)
+            d_mod = d_mod ? n - d_mod : 0;
+
+        int64_t jac = this->jacobi(d_mod, n);
+        if (jac == -1)
+            break;
+        if ((jac == 0) and (abs_d % n != 0))
+            return false;
+
+        // no such D exists for perfect squares, so rule them out early
+        if ((d_sel == 13) and is_square(n))
+            return false;
+
+        d_sel = (d_sel < 0) ? 2 - d_sel : -(d_sel + 2);
+    }
+
+    auto to_mont_signed = [&](int64_t x) {
+        uint64_t res = static_cast<uint64_t>((x < 0) ? -x : x) % n;
+        if ((x < 0) and res)
+            res = n - res;
+
+        return mont.to_mont(res);
+    };
+
+    const uint64_t d_m = to_mont_signed(d_sel);
+    const uint64_t q_m = to_mont_signed((1 - d_sel) / 4);
+
+    const uint64_t n_1 = n + 1; // n is odd and below 2^64 - 1 here
+    const uint32_t s = __builtin_ctzll(n_1);
+    const uint64_t d = n_1 >> s;
+
+    // U_1 = 1, V_1 = P = 1, Q^1 = Q
+    uint64_t u = mont.one, v = mont.one, qk = q_m, u_2k, v_2k;
+
+    for (int32_t bit = 62 - __builtin_clzll(d); bit >= 0; bit--)
+    {
+        // k -> 2k
+        u_2k = mont.mul(u, v);
+        v_2k = mont.sub(mont.mul(v, v), mont.add(qk, qk));
+        qk = mont.mul(qk, qk);
+
+        // 2k -> 2k + 1
+        if ((d >> bit) & 1)
+        {
+            u = mont.half(mont.add(u_2k, v_2k));
+            v = mont.half(mont.add(mont.mul(d_m, u_2k), v_2k));
+            qk = mont.mul(qk, q_m);
+        }
+        else
+        {
+            u = u_2k;
+            v = v_2k;
+        }
+    }
+
+    if ((u == 0) or (v == 0))
+        return true;
+
+    for (uint32_t r = 1; r < s; r++)
+    {
+        v = mont.sub(mont.mul(v, v), mont.add(qk, qk));
+        qk = mont.mul(qk, qk);
+
+        if (v == 0)
+            return true;
+    }
+
+    return false;
+}
+
+/*
+deterministic test for the whole 64-bit range (baillie-psw): trial division,
+a strong base-2 test and a strong lucas test. no composite below 2^64 passes
+both, so the answer is exact and costs about three exponentiations.
+*/
+
+bool SolvayStrassen::is_prime(uint64_t n) const
+{
+    switch (this->prefilter(n))
+    {
+        case COMPOSITE: return false;
+        case PRIME: return true;
+        default: break;
+    }
+
+    const Montgomery mont(n);
+
+    return this->strong_test(mont, 2) and this->strong_lucas_test(mont);
+}
+
+/*
+deterministic test over an array. candidates that survive the prefilter are
+queued SIMD_LANES at a time for the vectorized strong base-2 kernel, and only
+the ones that pass it run the (scalar) strong lucas test.
+*/
+
+void SolvayStrassen::is_prime_batch(const uint64_t *nums, uint8_t *primes, uint64_t count) const
+{
+    const StrongBase2Kernel kernel = strong_base2_kernel();
+
+    uint64_t lanes[SIMD_LANES], lane_idx[SIMD_LANES];
+    uint8_t pass[SIMD_LANES];
+    uint32_t n_lanes = 0;
+
+    auto flush = [&]() {
+        if (kernel)
+        {
+            // pad a partial group with copies of its first lane
+            for (uint32_t i = n_lanes; i < SIMD_LANES; i++)
+                lanes[i] = lanes[0];
+
+            kernel(lanes, pass);
+        }
+        else
+        {
+            for (uint32_t i = 0; i < n_lanes; i++)
+                pass[i] = this->strong_test(Montgomery(lanes[i]), 2);
+        }
+
+        for (uint32_t i = 0; i < n_lanes; i++)
+            primes[lane_idx[i]] = pass[i] and this->strong_lucas_test(Montgomery(lanes[i]));
+
+        n_lanes = 0;
+    };
+
+    for (uint64_t i = 0; i < count; i++)
+    {
+        switch (this->prefilter(nums[i]))
+        {
+            case COMPOSITE: primes[i] = 0; break;
+            case PRIME: primes[i] = 1; break;
+            default:
+                lanes[n_lanes] = nums[i];
+                lane_idx[n_lanes] = i;
+
+                if (++n_lanes == SIMD_LANES)
+                    flush();
+        }
+    }
+
+    if (n_lanes)
+        flush();
+}
+
+bool SolvayStrassen::is_prime(uint64_t n, uint64_t it) const
+{
+    // seeded once per thread, a random_device per call costs more than the test
+    thread_local std::mt19937_64 random(std::random_device{}());
+
+    return this->is_prime(n, it, random);
+}
+
+SolvayStrassen::Prefilter SolvayStrassen::prefilter(uint64_t n) const
+{
+    if (n < 11)
+        return ((n == 2) or (n == 3) or (n == 5) or (n == 7)) ? PRIME : COMPOSITE;
+
+    if (!WHEEL_210[n % 210])
+        return COMPOSITE;
+
+    for (uint32_t i = 0; i < U64_TRIAL_PRIMES; i++)
+    {
+        const SmallPrime &sp = SMALL_PRIMES[i];
+
+        if (sp.p * sp.p > n)
+            return PRIME;
+        if (n * sp.inv <= sp.lim)
+            return COMPOSITE;
+    }
+
+    return UNDECIDED;
+}
+
+SolvayStrassen::Prefilter SolvayStrassen::prefilter(const mpz_t &n) const
+{
+    if (mpz_sizeinbase(n, 2) <= 64)
+        return this->prefilter(static_cast<uint64_t>(mpz_get_ui(n)));
+
+    if (!WHEEL_210[mpz_fdiv_ui(n, 210)])
+        return COMPOSITE;
+
+    // one multi-precision remainder per group, then word-sized ones
+    for (const SmallPrimeGroup &group: SMALL_PRIME_GROUPS)
+    {
+        uint64_t rem = mpz_fdiv_ui(n, group.product);
+
+        for (uint32_t i = group.begin; i < group.end; i++)
+            if (rem * SMALL_PRIMES[i].inv <= SMALL_PRIMES[i].lim)
+                return COMPOSITE;
+    }
+
+    return UNDECIDED;
+}
+
+bool SolvayStrassen::is_prime(uint64_t n, uint64_t it, std::mt19937_64 &random) const
+{
+    switch (this->prefilter(n))
+    {
+        case COMPOSITE: return false;
+        case PRIME: return true;
+        default: return this->euler_test(n, it, random);
+    }
+}
+
+bool SolvayStrassen::euler_test(uint64_t n, uint64_t it, std::mt19937_64 &random) const
+{
+    if (n < 2)
+        return false;
+    if (n == 2)
+        return true;
+    if (n % 2 == 0)
+        return false;
+
+    const Montgomery mont(n);
+    const uint64_t minus_one = n - mont.one;
+
+    uint64_t a, mod;
+    int64_t jacobian;
+
+    std::uniform_int_distribution<uint64_t> dist(1, n - 1);
+
+    while (it--)
+    {
+        a = dist(random);
+        jacobian = this->jacobi(a, n);
+
+        if (jacobian == 0)
+            return false;
+
+        // euler's criterion: a^((n - 1) / 2) = (a / n) mod n
+        mod = mont.pow(mont.to_mont(a), (n - 1) >> 1);
+
+        if (mod != ((jacobian == 1) ? mont.one : minus_one))
+            return false;
+    }
+
+    return true;
+}
+
+bool SolvayStrassen::is_prime(const mpz_t &n, uint64_t it)
+{
+    if (mpz_sgn(n) <= 0)
+        return false;
+    if (mpz_sizeinbase(n, 2) <= 64)
+        return this->is_prime(static_cast<uint64_t>(mpz_get_ui(n)), it);
+    if (this->prefilter(n) == COMPOSITE)
+        return false;
+
+    mpz_sub_ui(this->mp_n_1, n, 1);
+    mpz_tdiv_q_2exp(this->mp_e, this->mp_n_1, 1);
+
+    int64_t jacobian;
+
+    while (it--)
+    {
+        // a uniform in [1, n - 1]
+        mpz_urandomm(this->mp_a, this->mp_random, this->mp_n_1);
+        mpz_add_ui(this->mp_a, this->mp_a, 1);
+
+        jacobian = this->jacobi(this->mp_a, n);
+
+        if (jacobian == 0)
+            return false;
+
+        mpz_powm(this->mp_mod, this->mp_a, this->mp_e, n);
+
+        if (jacobian == 1)
+        {
+            if (mpz_cmp_ui(this->mp_mod, 1) != 0)
+                return false;
+        }
+        else if (mpz_cmp(this->mp_mod, this->mp_n_1) != 0)
+            return false;
+    }
+
+    return true;
+}
+
+#endif
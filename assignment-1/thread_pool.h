@@ -0,0 +1,107 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <cstdint>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+
+/*
+a fixed set of worker threads that repeatedly run batches of indexed tasks.
+run() hands out task indices [0, n_tasks) dynamically and blocks until the
+whole batch is done, so callers can keep per-batch results in input order.
+each task also receives the id of the worker running it, which lets callers
+keep per-thread state (random engines, scratch buffers) without locking.
+*/
+
+class ThreadPool
+{
+    private:
+        std::vector<std::thread> workers;
+        std::mutex mtx;
+        std::condition_variable cv_work;
+        std::condition_variable cv_done;
+
+        std::function<void(uint32_t, uint64_t)> task;
+        std::atomic<uint64_t> next_task;
+        uint64_t n_tasks;
+        uint64_t generation;
+        uint32_t busy;
+        bool stop;
+
+        void work(uint32_t);
+
+    public:
+        const uint32_t size;
+
+        ThreadPool(uint32_t);
+        ~ThreadPool();
+
+        void run(uint64_t, const std::function<void(uint32_t, uint64_t)> &);
+};
+
+ThreadPool::ThreadPool(uint32_t size)
+    : next_task(0), n_tasks(0), generation(0), busy(0), stop(false),
+      size(size ? size : 1)
+{
+    for (uint32_t i = 0; i < this->size; i++)
+        this->workers.emplace_back(&ThreadPool::work, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mtx);
+        this->stop = true;
+    }
+
+    this->cv_work.notify_all();
+
+    for (std::thread &worker: this->workers)
+        worker.join();
+}
+
+void ThreadPool::work(uint32_t id)
+{
+    uint64_t seen = 0, idx;
+
+    while (true)
+    {
+        std::unique_lock<std::mutex> lock(this->mtx);
+        this->cv_work.wait(lock, [&]() {
+            return this->stop or (this->generation != seen);
+        });
+
+        if (this->stop)
+            return;
+
+        seen = this->generation;
+        lock.unlock();
+
+        while ((idx = this->next_task.fetch_add(1)) < this->n_tasks)
+            this->task(id, idx);
+
+        lock.lock();
+        if (--this->busy == 0)
+            this->cv_done.notify_all();
+    }
+}
+
+void ThreadPool::run(uint64_t n_tasks, const std::function<void(uint32_t, uint64_t)> &task)
+{
+    std::unique_lock<std::mutex> lock(this->mtx);
+
+    this->task = task;
+    this->n_tasks = n_tasks;
+    this->next_task = 0;
+    this->busy = this->size;
+    this->generation++;
+
+    this->cv_work.notify_all();
+    this->cv_done.wait(lock, [&]() { return this->busy == 0; });
+}
+
+#endif
@@ -0,0 +1,232 @@
+#ifndef BASIC_SPN_H
+#define BASIC_SPN_H
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <type_traits>
+#include "spn.h"
+
+/*
+SPN with the same structure as the SPN class (ROUNDS rounds of key mixing,
+sbox and bit permutation, then a last key mixing, sbox and key mixing) but
+with the block width, number of rounds, sbox and pbox fixed at compile time.
+
+the key is (ROUNDS + 2) subkeys of BITS bits, read big-endian from
+key bytes just like SPNKey. rounds are unrolled with index
+sequences and each one is a key XOR and one table lookup per state byte
+into fused P(S(x)) tables, which are built at compile time per instance.
+decryption keeps the state in the permuted domain like SPN::decrypt.
+
+BasicSPN<16, 3, SPN_SBOX, SPN_PBOX> is the cipher of the SPN class.
+*/
+
+template <uint32_t BITS>
+using SPNBlock = typename std::conditional<BITS == 16, uint16_t,
+    typename std::conditional<BITS == 32, uint32_t, uint64_t>::type>::type;
+
+template <uint32_t BITS>
+using SPNPBox = std::array<uint8_t, BITS>;
+
+/*
+the generalised heys / PRESENT transposition: bit i goes to i * BITS / 4
+mod (BITS - 1), the last bit stays. for 16 bits this is SPN_PBOX.
+*/
+
+template <uint32_t BITS>
+constexpr SPNPBox<BITS> transposition_pbox(void)
+{
+    SPNPBox<BITS> pbox {};
+    for (uint32_t i = 0; i < BITS - 1; i++)
+        pbox[i] = (i * (BITS / 4)) % (BITS - 1);
+
+    pbox[BITS - 1] = BITS - 1;
+
+    return pbox;
+}
+
+template <uint32_t BITS>
+constexpr SPNPBox<BITS> invert_pbox(const SPNPBox<BITS> &pbox)
+{
+    SPNPBox<BITS> inv {};
+    for (uint32_t i = 0; i < BITS; i++)
+        inv[pbox[i]] = i;
+
+    return inv;
+}
+
+template <uint32_t BITS>
+constexpr SPNBlock<BITS> permute_block(SPNBlock<BITS> state, const SPNPBox<BITS> &pbox)
+{
+    SPNBlock<BITS> permuted = 0;
+    for (uint32_t bit = 0; bit < BITS; bit++)
+        permuted |= static_cast<SPNBlock<BITS>>((state >> bit) & 1) << pbox[bit];
+
+    return permuted;
+}
+
+template <uint32_t BITS>
+using SPNTable = std::array<std::array<SPNBlock<BITS>, 256>, BITS / 8>;
+
+// entry [h][b] is byte b substituted nibble-wise, placed in byte h and optionally permuted
+template <uint32_t BITS>
+constexpr SPNTable<BITS> make_spn_table(const std::array<uint8_t, 16> &sbox, const SPNPBox<BITS> *pbox)
+{
+    SPNTable<BITS> table {};
+
+    for (uint32_t byte_idx = 0; byte_idx < BITS / 8; byte_idx++)
+    {
+        for (uint32_t byte = 0; byte < 256; byte++)
+        {
+            SPNBlock<BITS> sub = sbox[byte & 0xf] | (sbox[byte >> 4] << 4);
+            sub <<= byte_idx << 3;
+            table[byte_idx][byte] = pbox ? permute_block<BITS>(sub, *pbox) : sub;
+        }
+    }
+
+    return table;
+}
+
+template <uint32_t BITS, uint32_t ROUNDS, const std::array<uint8_t, 16> &SBOX, const SPNPBox<BITS> &PBOX>
+class BasicSPN
+{
+    static_assert(BITS == 16 or BITS == 32 or BITS == 64, "block width must be 16, 32 or 64 bits");
+    static_assert(ROUNDS > 0, "at least one full round is needed");
+
+    public:
+        typedef SPNBlock<BITS> Block;
+        typedef std::array<Block, ROUNDS + 2> SubKeys;
+
+        static const uint32_t block_size = BITS;
+        static const uint32_t rounds = ROUNDS;
+        static const uint32_t key_size = (ROUNDS + 2) * BITS / 8;
+
+    private:
+        static constexpr std::array<uint8_t, 16> INV_SBOX = invert_sbox(SBOX);
+        static constexpr SPNPBox<BITS> INV_PBOX = invert_pbox<BITS>(PBOX);
+
+        static constexpr SPNTable<BITS> ENC_ROUND = make_spn_table<BITS>(SBOX, &PBOX);
+        static constexpr SPNTable<BITS> ENC_FINAL = make_spn_table<BITS>(SBOX, nullptr);
+        static constexpr SPNTable<BITS> DEC_ROUND = make_spn_table<BITS>(INV_SBOX, &INV_PBOX);
+        static constexpr SPNTable<BITS> DEC_FINAL = make_spn_table<BITS>(INV_SBOX, nullptr);
+
+        typedef std::make_index_sequence<BITS / 8> Bytes;
+
+        template <size_t... H>
+        static Block apply_round(const SPNTable<BITS> &, Block, std::index_sequence<H...>);
+
+        template <size_t... R>
+        static Block encrypt_rounds(Block, const SubKeys &, std::index_sequence<R...>);
+
+        template <size_t... R>
+        static Block decrypt_rounds(Block, const SubKeys &, std::index_sequence<R...>);
+
+    public:
+        static SubKeys expand_key(const std::vector<uint32_t> &);
+        static SubKeys expand_dec_key(const SubKeys &);
+
+        // decryption takes the subkeys returned by expand_dec_key
+        static Block encrypt(Block, const SubKeys &);
+        static Block decrypt(Block, const SubKeys &);
+
+        static void encrypt(const Block *, Block *, size_t, const SubKeys &);
+        static void decrypt(const Block *, Block *, size_t, const SubKeys &);
+};
+
+template <uint32_t BITS, uint32_t ROUNDS, const std::array<uint8_t, 16> &SBOX, const SPNPBox<BITS> &PBOX>
+template <size_t... H>
+inline typename BasicSPN<BITS, ROUNDS, SBOX, PBOX>::Block
+BasicSPN<BITS, ROUNDS, SBOX, PBOX>::apply_round(const SPNTable<BITS> &table, Block state, std::index_sequence<H...>)
+{
+    return (table[H][(state >> (H << 3)) & 0xff] ^ ...);
+}
+
+template <uint32_t BITS, uint32_t ROUNDS, const std::array<uint8_t, 16> &SBOX, const SPNPBox<BITS> &PBOX>
+template <size_t... R>
+inline typename BasicSPN<BITS, ROUNDS, SBOX, PBOX>::Block
+BasicSPN<BITS, ROUNDS, SBOX, PBOX>::encrypt_rounds(Block state, const SubKeys &sub_keys, std::index_sequence<R...>)
+{
+    ((state = apply_round(ENC_ROUND, state ^ sub_keys[R], Bytes())), ...);
+
+    return state;
+}
+
+// undoes rounds ROUNDS down to 2, the subkeys already permuted
+template <uint32_t BITS, uint32_t ROUNDS, const std::array<uint8_t, 16> &SBOX, const SPNPBox<BITS> &PBOX>
+template <size_t... R>
+inline typename BasicSPN<BITS, ROUNDS, SBOX, PBOX>::Block
+BasicSPN<BITS, ROUNDS, SBOX, PBOX>::decrypt_rounds(Block state, const SubKeys &dec_keys, std::index_sequence<R...>)
+{
+    ((state = apply_round(DEC_ROUND, state ^ dec_keys[ROUNDS - R], Bytes())), ...);
+
+    return state;
+}
+
+template <uint32_t BITS, uint32_t ROUNDS, const std::array<uint8_t, 16> &SBOX, const SPNPBox<BITS> &PBOX>
+typename BasicSPN<BITS, ROUNDS, SBOX, PBOX>::SubKeys
+BasicSPN<BITS, ROUNDS, SBOX, PBOX>::expand_key(const std::vector<uint32_t> &key)
+{
+    SubKeys sub_keys {};
+
+    for (uint32_t i = 0; i < ROUNDS + 2; i++)
+        for (uint32_t byte = 0; byte < BITS / 8; byte++)
+            sub_keys[i] = (sub_keys[i] << 8) | (key.at(i * (BITS / 8) + byte) & 0xff);
+
+    return sub_keys;
+}
+
+// the middle subkeys move through the inverse permutation for decryption
+template <uint32_t BITS, uint32_t ROUNDS, const std::array<uint8_t, 16> &SBOX, const SPNPBox<BITS> &PBOX>
+typename BasicSPN<BITS, ROUNDS, SBOX, PBOX>::SubKeys
+BasicSPN<BITS, ROUNDS, SBOX, PBOX>::expand_dec_key(const SubKeys &sub_keys)
+{
+    SubKeys dec_keys = sub_keys;
+
+    for (uint32_t rnum = 1; rnum <= ROUNDS; rnum++)
+        dec_keys[rnum] = permute_block<BITS>(sub_keys[rnum], INV_PBOX);
+
+    return dec_keys;
+}
+
+template <uint32_t BITS, uint32_t ROUNDS, const std::array<uint8_t, 16> &SBOX, const SPNPBox<BITS> &PBOX>
+inline typename BasicSPN<BITS, ROUNDS, SBOX, PBOX>::Block
+BasicSPN<BITS, ROUNDS, SBOX, PBOX>::encrypt(Block state, const SubKeys &sub_keys)
+{
+    state = encrypt_rounds(state, sub_keys, std::make_index_sequence<ROUNDS>());
+    state = apply_round(ENC_FINAL, state ^ sub_keys[ROUNDS], Bytes());
+
+    return state ^ sub_keys[ROUNDS + 1];
+}
+
+template <uint32_t BITS, uint32_t ROUNDS, const std::array<uint8_t, 16> &SBOX, const SPNPBox<BITS> &PBOX>
+inline typename BasicSPN<BITS, ROUNDS, SBOX, PBOX>::Block
+BasicSPN<BITS, ROUNDS, SBOX, PBOX>::decrypt(Block state, const SubKeys &dec_keys)
+{
+    state = apply_round(DEC_ROUND, state ^ dec_keys[ROUNDS + 1], Bytes());
+    state = decrypt_rounds(state, dec_keys, std::make_index_sequence<ROUNDS - 1>());
+    state = apply_round(DEC_FINAL, state ^ dec_keys[1], Bytes());
+
+    return state ^ dec_keys[0];
+}
+
+template <uint32_t BITS, uint32_t ROUNDS, const std::array<uint8_t, 16> &SBOX, const SPNPBox<BITS> &PBOX>
+void BasicSPN<BITS, ROUNDS, SBOX, PBOX>::encrypt(const Block *pt, Block *ct, size_t n, const SubKeys &sub_keys)
+{
+    for (size_t i = 0; i < n; i++)
+        ct[i] = encrypt(pt[i], sub_keys);
+}
+
+template <uint32_t BITS, uint32_t ROUNDS, const std::array<uint8_t, 16> &SBOX, const SPNPBox<BITS> &PBOX>
+void BasicSPN<BITS, ROUNDS, SBOX, PBOX>::decrypt(const Block *ct, Block *pt, size_t n, const SubKeys &dec_keys)
+{
+    for (size_t i = 0; i < n; i++)
+        pt[i] = decrypt(ct[i], dec_keys);
+}
+
+constexpr SPNPBox<32> SPN_PBOX_32 = transposition_pbox<32>();
+constexpr SPNPBox<64> SPN_PBOX_64 = transposition_pbox<64>();
+
+typedef BasicSPN<16, 3, SPN_SBOX, SPN_PBOX> HeysSPN;
+
+#endif
@@ -0,0 +1,215 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <random>
+#include <cstdlib>
+#include <new>
+#include <functional>
+#include "spn.h"
+#include "basic_spn.h"
+#include "codebook.h"
+#include "lca.h"
+
+#if defined(__x86_64__) or defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_CYCLES() __rdtsc()
+#else
+#define BENCH_CYCLES() 0ull
+#endif
+
+/*
+SPN benchmarks, one CSV row per case on stdout:
+
+name,op,batch,unit,units,seconds,units_per_sec,cycles_per_unit,allocs_per_unit
+
+every implementation encrypts and decrypts buffers of each batch size
+(blocks) until at least `min seconds` have passed: the vector and span
+APIs (table lookups), each bitsliced kernel the cpu supports, the
+compile-time BasicSPN and the full codebook (whose build is timed as its
+own case, one unit per codebook). the whole linear_cryptanalysis run is
+timed last with its output thrown away, one unit per run.
+
+cycles are time stamp counter ticks, which run at the nominal clock rather
+than the actual one, and allocations are counted by replacing the global
+operator new.
+*/
+
+static std::atomic<uint64_t> n_allocs(0);
+
+/*
+kept out of line: once inlined, gcc pairs the free() in delete with the
+library's operator new at the call site and reports a mismatch.
+*/
+
+__attribute__((noinline))
+void *operator new(size_t size)
+{
+    n_allocs.fetch_add(1, std::memory_order_relaxed);
+
+    if (void *ptr = std::malloc(size ? size : 1))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+__attribute__((noinline))
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+__attribute__((noinline))
+void operator delete(void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+static volatile uint32_t sink;
+
+// run `body` (which handles `units` units per call) for at least min_secs and print its row
+static void bench(const std::string &name, const std::string &op, size_t batch, const std::string &unit,
+    uint64_t units, double min_secs, const std::function<void(void)> &body)
+{
+    body();
+
+    uint64_t calls = 0, allocs = n_allocs.load();
+    uint64_t cycles = BENCH_CYCLES();
+    auto start = std::chrono::steady_clock::now();
+    double secs = 0.0;
+
+    do
+    {
+        body();
+        calls++;
+        secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    while (secs < min_secs);
+
+    cycles = BENCH_CYCLES() - cycles;
+    allocs = n_allocs.load() - allocs;
+
+    const double total = static_cast<double>(calls * units);
+
+    std::cout << name << "," << op << "," << batch << "," << unit << "," << calls * units << ",";
+    std::cout << secs << "," << total / secs << "," << cycles / total << "," << allocs / total << std::endl;
+}
+
+int main(int argc, char *argv[])
+{
+    double min_secs = 0.2;
+    std::vector<size_t> batches {1, 64, 1024, 65536};
+
+    try
+    {
+        if (argc > 1) min_secs = std::stod(argv[1]);
+
+        if (argc > 2)
+        {
+            batches.clear();
+            for (int i = 2; i < argc; i++)
+            {
+                batches.push_back(std::stoull(argv[i]));
+                if (!batches.back())
+                    throw std::invalid_argument("empty batch");
+            }
+        }
+    }
+    catch (const std::exception &)
+    {
+        std::cerr << "Usage: " << argv[0] << " [min seconds per case] [batch sizes ...]\n";
+        return 1;
+    }
+
+    const SPN spn;
+    std::mt19937_64 rng(1);
+    const std::vector<uint32_t> key = spn.get_rand_key(rng);
+    const SPNKey expanded(key);
+
+    const HeysSPN::SubKeys heys_keys = HeysSPN::expand_key(key);
+    const HeysSPN::SubKeys heys_dec_keys = HeysSPN::expand_dec_key(heys_keys);
+
+    struct Kernel
+    {
+        const char *name;
+        SPNBatchKernel enc, dec;
+        bool supported;
+    };
+
+    __builtin_cpu_init();
+    const Kernel kernels[] = {
+        {"bitslice_u64", spn_batch_u64<false>, spn_batch_u64<true>, true},
+        {"bitslice_avx2", spn_batch_avx2<false>, spn_batch_avx2<true>, __builtin_cpu_supports("avx2") != 0},
+        {"bitslice_avx512", spn_batch_avx512<false>, spn_batch_avx512<true>, __builtin_cpu_supports("avx512f") != 0}
+    };
+
+    const char *dispatched;
+    spn_batch_kernel(false, &dispatched);
+    std::cerr << "encrypt_batch dispatches to " << dispatched << "\n";
+
+    std::cout << "name,op,batch,unit,units,seconds,units_per_sec,cycles_per_unit,allocs_per_unit\n";
+
+    SPNCodebook *codebook = nullptr;
+    bench("codebook_build", "build", CODEBOOK_SIZE, "codebook", 1, min_secs, [&]() {
+        delete codebook;
+        codebook = new SPNCodebook(spn, expanded);
+    });
+
+    for (const size_t batch: batches)
+    {
+        std::vector<uint32_t> in32(batch), out32(batch);
+        std::vector<uint16_t> in16(batch), out16(batch);
+
+        for (size_t i = 0; i < batch; i++)
+            in32[i] = in16[i] = rng() & 0xffff;
+
+        for (const bool decrypt: {false, true})
+        {
+            const std::string op = decrypt ? "decrypt" : "encrypt";
+
+            bench("spn_vector", op, batch, "block", batch, min_secs, [&]() {
+                std::vector<uint32_t> out = decrypt ? spn.decrypt(in32, expanded) : spn.encrypt(in32, expanded);
+                sink = out[0];
+            });
+
+            bench("spn_span", op, batch, "block", batch, min_secs, [&]() {
+                if (decrypt) spn.decrypt(in32, out32, expanded);
+                else spn.encrypt(in32, out32, expanded);
+                sink = out32[0];
+            });
+
+            for (const Kernel &kernel: kernels)
+            {
+                if (!kernel.supported)
+                    continue;
+
+                bench(kernel.name, op, batch, "block", batch, min_secs, [&]() {
+                    (decrypt ? kernel.dec : kernel.enc)(in16.data(), out16.data(), batch, expanded.sub_keys.data(), spn.rounds);
+                    sink = out16[0];
+                });
+            }
+
+            bench("basic_spn", op, batch, "block", batch, min_secs, [&]() {
+                if (decrypt) HeysSPN::decrypt(in16.data(), out16.data(), batch, heys_dec_keys);
+                else HeysSPN::encrypt(in16.data(), out16.data(), batch, heys_keys);
+                sink = out16[0];
+            });
+
+            bench("codebook", op, batch, "block", batch, min_secs, [&]() {
+                if (decrypt) codebook->decrypt(in16.data(), out16.data(), batch);
+                else codebook->encrypt(in16.data(), out16.data(), batch);
+                sink = out16[0];
+            });
+        }
+    }
+
+    delete codebook;
+
+    std::ostream discard(nullptr);
+    bench("linear_cryptanalysis", "run", 10000, "run", 1, min_secs, [&]() {
+        sink = linear_cryptanalysis(discard);
+    });
+
+    return 0;
+}
@@ -0,0 +1,155 @@
+#ifndef BITSLICE_H
+#define BITSLICE_H
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+/*
+building blocks for bitsliced 16-bit block ciphers. a batch of blocks is
+held as 16 lane words where word b carries bit b of every block, so one
+bitwise instruction acts on that bit of all the blocks at once. lane words
+are plain uint64_t (64 blocks) or GCC vector types (256 and 512 blocks),
+and the helpers are always inlined so each one compiles to the instruction
+set of the kernel that calls it.
+
+blocks are copied in as they are, so word r, 16-bit group g starts out
+holding block r * G + g (G groups per word). the 16x16 transpose works on
+each group separately and leaves bit b of that block in word b, group g,
+bit r. the bit order inside a lane word does not matter to a cipher that
+treats all blocks alike, and the transpose is its own inverse, so storing
+puts every block back where it came from.
+*/
+
+#define BITSLICE_INLINE inline __attribute__((always_inline))
+
+typedef uint64_t Lanes64;
+typedef uint64_t Lanes256 __attribute__((vector_size(32)));
+typedef uint64_t Lanes512 __attribute__((vector_size(64)));
+
+template <typename W>
+struct LaneTraits
+{
+    static const uint32_t blocks = sizeof(W) * 8;
+};
+
+template <typename W>
+BITSLICE_INLINE void transpose16(W *s)
+{
+    constexpr uint64_t MASKS[4] = {
+        0x00ff00ff00ff00ff, 0x0f0f0f0f0f0f0f0f,
+        0x3333333333333333, 0x5555555555555555
+    };
+
+    #pragma GCC unroll 4
+    for (uint32_t stage = 0, j = 8; j; stage++, j >>= 1)
+    {
+        const W m = W {} + MASKS[stage];
+
+        #pragma GCC unroll 16
+        for (uint32_t k = 0; k < 16; k++)
+        {
+            if (k & j)
+                continue;
+
+            W t = ((s[k] >> j) ^ s[k + j]) & m;
+            s[k + j] ^= t;
+            s[k] ^= t << j;
+        }
+    }
+}
+
+// LaneTraits<W>::blocks consecutive blocks into 16 lane words
+template <typename W>
+BITSLICE_INLINE void bitslice_load(const uint16_t *blocks, W *s)
+{
+    std::memcpy(s, blocks, 16 * sizeof(W));
+    transpose16(s);
+}
+
+template <typename W>
+BITSLICE_INLINE void bitslice_store(W *s, uint16_t *blocks)
+{
+    transpose16(s);
+    std::memcpy(blocks, s, 16 * sizeof(W));
+}
+
+/*
+algebraic normal form of each output bit of a 4-bit sbox: bit u of anf[o]
+is set when the monomial made of the input bits in u appears in output o.
+*/
+
+constexpr std::array<uint16_t, 4> sbox_anf(const std::array<uint8_t, 16> &sbox)
+{
+    std::array<uint16_t, 4> anf {};
+
+    for (uint32_t o = 0; o < 4; o++)
+    {
+        uint32_t f[16] {};
+        for (uint32_t x = 0; x < 16; x++)
+            f[x] = (sbox[x] >> o) & 1;
+
+        // moebius transform
+        for (uint32_t step = 1; step < 16; step <<= 1)
+            for (uint32_t x = 0; x < 16; x++)
+                if (x & step) f[x] ^= f[x ^ step];
+
+        for (uint32_t u = 0; u < 16; u++)
+            anf[o] |= f[u] << u;
+    }
+
+    return anf;
+}
+
+/*
+the sbox as a boolean circuit: the 16 monomials of a nibble are built with
+11 ANDs and every output bit XORs the ones in its normal form. ANF is a
+compile-time table so the loops fold down to straight-line code.
+*/
+
+template <const std::array<uint16_t, 4> &ANF, typename W>
+BITSLICE_INLINE void sbox_layer(W *s)
+{
+    #pragma GCC unroll 4
+    for (uint32_t nibble = 0; nibble < 16; nibble += 4)
+    {
+        W mono[16];
+        mono[0] = ~W {};
+
+        #pragma GCC unroll 16
+        for (uint32_t u = 1; u < 16; u++)
+            mono[u] = mono[u & (u - 1)] & s[nibble + __builtin_ctz(u)];
+
+        #pragma GCC unroll 4
+        for (uint32_t o = 0; o < 4; o++)
+        {
+            W y {};
+
+            #pragma GCC unroll 16
+            for (uint32_t u = 0; u < 16; u++)
+                if ((ANF[o] >> u) & 1) y ^= mono[u];
+
+            s[nibble + o] = y;
+        }
+    }
+}
+
+// the bit permutation is only a relabeling of the lane words
+template <const std::array<uint8_t, 16> &PBOX, bool INVERSE, typename W>
+BITSLICE_INLINE void perm_layer(W *s)
+{
+    W t[16];
+
+    #pragma GCC unroll 16
+    for (uint32_t b = 0; b < 16; b++)
+    {
+        if (INVERSE) t[b] = s[PBOX[b]];
+        else t[PBOX[b]] = s[b];
+    }
+
+    #pragma GCC unroll 16
+    for (uint32_t b = 0; b < 16; b++)
+        s[b] = t[b];
+}
+
+#endif
@@ -0,0 +1,163 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <thread>
+#include <random>
+#include <cmath>
+#include "bruteforce.h"
+
+const uint32_t BF_MAX_PAIRS = 1 << 16;     // every plaintext once
+const uint32_t BF_MAX_THREADS = 1024;
+
+/*
+draw a random key and known pairs, forget some of the key bits and search
+for them with bruteforce.h. the unknown bits are given either as a count
+(the lowest bits of the key) or as a 20 hex digit mask over the key bytes.
+--all searches the whole space instead of stopping at the first key that
+fits every pair, which shows when there are too few pairs to pin the key
+down. the rate is printed together with the number of unknown bits one
+thread pool gets through in a second, a minute and an hour.
+*/
+
+static std::string key_hex(const std::vector<uint32_t> &key)
+{
+    std::stringstream ss;
+    for (const uint32_t byte: key)
+        ss << std::setfill('0') << std::setw(2) << std::hex << byte;
+
+    return ss.str();
+}
+
+static bool parse_unknown(const std::string &arg, std::vector<uint32_t> &mask)
+{
+    mask.assign(10, 0);
+
+    if (arg.size() == 20)
+    {
+        if (arg.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos)
+            return false;
+
+        for (uint32_t i = 0; i < 10; i++)
+            mask[i] = std::stoul(arg.substr(i << 1, 2), nullptr, 16);
+
+        return true;
+    }
+
+    if (arg.empty() or (arg.find_first_not_of("0123456789") != std::string::npos))
+        return false;
+
+    const uint32_t bits = std::stoul(arg);
+    if (bits > 80)
+        return false;
+
+    for (uint32_t bit = 0; bit < bits; bit++)
+        mask[9 - (bit >> 3)] |= 1 << (bit & 7);
+
+    return true;
+}
+
+// a plain decimal count in [1, max]; stoul alone would take "-1" and wrap it
+static uint32_t parse_count(const std::string &arg, uint32_t max)
+{
+    if (arg.empty() or (arg.size() > 10) or (arg.find_first_not_of("0123456789") != std::string::npos))
+        throw std::invalid_argument(arg);
+
+    const uint64_t count = std::stoull(arg);
+    if ((count == 0) or (count > max))
+        throw std::out_of_range(arg);
+
+    return count;
+}
+
+static int usage(const char *prog)
+{
+    std::cerr << "Usage: " << prog << " <unknown bits | 20 hex digit mask> [known pairs] [threads] [seed] [--all]\n";
+    std::cerr << "       (1 to " << BF_MAX_PAIRS << " known pairs, 1 to " << BF_MAX_THREADS << " threads)\n";
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    const bool all = (argc > 1) and (std::string(argv[argc - 1]) == "--all");
+    if (all)
+        argc--;
+
+    std::vector<uint32_t> mask;
+    if ((argc < 2) or !parse_unknown(argv[1], mask))
+        return usage(argv[0]);
+
+    uint32_t n_unknown = 0;
+    for (const uint32_t byte: mask)
+        n_unknown += __builtin_popcount(byte);
+
+    uint32_t n_pairs = BF_DEFAULT_PAIRS;
+    uint32_t n_threads = std::thread::hardware_concurrency();
+    uint64_t seed = std::random_device {}();
+
+    try
+    {
+        if (argc > 2) n_pairs = parse_count(argv[2], BF_MAX_PAIRS);
+        if (argc > 3) n_threads = parse_count(argv[3], BF_MAX_THREADS);
+        if (argc > 4) seed = std::stoull(argv[4], nullptr, 0);
+    }
+    catch (const std::exception &)
+    {
+        return usage(argv[0]);
+    }
+
+    const SPN spn;
+    std::mt19937_64 rng(seed);
+    const std::vector<uint32_t> key = spn.get_rand_key(rng);
+
+    std::vector<uint16_t> pts(n_pairs), cts(n_pairs);
+    for (uint16_t &pt: pts)
+        pt = rng() & 0xffff;
+
+    spn.encrypt_batch(pts, cts, key);
+
+    // the guess is wrong in every unknown bit, which the search must not care about
+    std::vector<uint32_t> guess(key);
+    for (uint32_t i = 0; i < guess.size(); i++)
+        guess[i] ^= mask[i];
+
+    BruteForceSpace space;
+    BruteForceResult result;
+
+    try
+    {
+        space = bf_space(guess, mask);
+        result = bf_search(spn, space, pts.data(), cts.data(), n_pairs, n_threads, !all);
+    }
+    catch (const std::exception &exc)
+    {
+        std::cerr << exc.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "seed " << seed << ", key " << key_hex(key) << ", unknown mask " << key_hex(mask);
+    std::cout << " (" << n_unknown << " bits), " << n_pairs << " known pairs\n";
+
+    bool found = false;
+    for (const std::vector<uint32_t> &candidate: result.keys)
+    {
+        std::cout << "    consistent key " << key_hex(candidate) << (candidate == key ? " (true key)" : "") << "\n";
+        found |= (candidate == key);
+    }
+
+    const double rate = result.keys_per_sec();
+
+    std::cout << result.tested << " of " << (1ull << n_unknown) << " keys in " << result.seconds << " s, ";
+    std::cout << rate / 1e6 << " M keys/s (" << result.kernel << ", " << result.threads << " threads)\n";
+
+    if (rate > 0)
+    {
+        std::cout << "feasible unknown bits: " << std::fixed << std::setprecision(1) << std::log2(rate) << " per second, ";
+        std::cout << std::log2(rate * 60) << " per minute, " << std::log2(rate * 3600) << " per hour\n";
+    }
+
+    std::cout << (found ? "Success!\n" : "Failure\n");
+
+    return !found;
+}
@@ -0,0 +1,393 @@
+#ifndef BRUTEFORCE_H
+#define BRUTEFORCE_H
+
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include "spn.h"
+
+/*
+exhaustive search over the key bits an attack left unknown. key bit
+16 * i + b is bit b of subkey K_{i+1}; the unknown bits are numbered from
+the lowest position up and candidate c sets unknown bit j to bit j of c,
+the known bits come from a key guess.
+
+the kernels are bitsliced over keys rather than blocks: the one plaintext
+is broadcast to every lane and each lane carries its own key, held as 16
+lane words per subkey like the state. the lowest log2(lanes) unknown bits
+take the fixed patterns of the lane index (0xaaaa.., 0xcccc.., ...) and the
+others are all zero or all ones for a whole pass, so a pass costs the same
+as encrypting one batch of blocks and needs no transposes. lanes whose
+ciphertext matches the first pair (one in 2^16 of the wrong keys) are then
+checked against every pair with SPN::encrypt_batch.
+
+the candidates are split into BF_CHUNK_KEYS chunks and every worker starts
+with an equal range of them. a worker takes chunks from the front of its
+own range and, once that is empty, steals the back half of the biggest
+range left, so threads slowed down by anything else on the machine do not
+hold up the end of the search. with stop_early the workers give up at the
+next chunk after a key consistent with all the pairs turned up.
+*/
+
+const uint64_t BF_CHUNK_KEYS = 1 << 16;
+const uint32_t BF_MAX_UNKNOWN = 48;
+const uint32_t BF_DEFAULT_PAIRS = 8;
+
+static_assert(BF_CHUNK_KEYS % LaneTraits<Lanes512>::blocks == 0, "chunks must hold whole passes");
+
+struct BruteForceSpace
+{
+    std::array<uint32_t, SPN_SUB_KEYS> base;    // the key guess with every unknown bit cleared
+    std::vector<uint32_t> unknown;              // positions of the unknown bits, ascending
+};
+
+struct BruteForceResult
+{
+    std::vector<std::vector<uint32_t>> keys;    // every candidate consistent with all the pairs
+    uint64_t tested;
+    double seconds;
+    const char *kernel;
+    uint32_t threads;                           // workers actually started
+
+    double keys_per_sec(void) const;
+};
+
+double BruteForceResult::keys_per_sec(void) const
+{
+    return (this->seconds > 0) ? this->tested / this->seconds : 0.0;
+}
+
+// `unknown_mask` and `guess` are ten key bytes, the set bits of the mask are searched for
+BruteForceSpace bf_space(const std::vector<uint32_t> &guess, const std::vector<uint32_t> &unknown_mask)
+{
+    const SPNKey known(guess), mask(unknown_mask);
+    BruteForceSpace space;
+
+    for (uint32_t i = 0; i < SPN_SUB_KEYS; i++)
+    {
+        space.base[i] = known.sub_keys[i] & ~mask.sub_keys[i];
+
+        for (uint32_t b = 0; b < 16; b++)
+            if ((mask.sub_keys[i] >> b) & 1) space.unknown.push_back((i << 4) + b);
+    }
+
+    if (space.unknown.size() > BF_MAX_UNKNOWN)
+        throw std::invalid_argument("too many unknown key bits for an exhaustive search");
+
+    return space;
+}
+
+// the key bytes of candidate c
+std::vector<uint32_t> bf_candidate_key(const BruteForceSpace &space, uint64_t candidate)
+{
+    std::array<uint32_t, SPN_SUB_KEYS> sub_keys = space.base;
+    for (uint32_t j = 0; j < space.unknown.size(); j++)
+        sub_keys[space.unknown[j] >> 4] |= ((candidate >> j) & 1) << (space.unknown[j] & 0xf);
+
+    std::vector<uint32_t> key;
+    for (const uint32_t k: sub_keys)
+    {
+        key.push_back(k >> 8);
+        key.push_back(k & 0xff);
+    }
+
+    return key;
+}
+
+/*
+kernels: encrypt pt under candidates first .. first + count - 1 (first a
+multiple of the lane count) and append those whose ciphertext is ct to
+hits.
+*/
+
+typedef void (*BFKernel)(const BruteForceSpace &, uint16_t, uint16_t, uint64_t, uint64_t, std::vector<uint64_t> &);
+
+// all ones in the lanes whose index has bit j set
+template <typename W>
+BITSLICE_INLINE void bf_lane_pattern(uint32_t j, W &pattern)
+{
+    constexpr uint64_t PATTERNS[6] = {
+        0xaaaaaaaaaaaaaaaa, 0xcccccccccccccccc, 0xf0f0f0f0f0f0f0f0,
+        0xff00ff00ff00ff00, 0xffff0000ffff0000, 0xffffffff00000000
+    };
+
+    uint64_t words[sizeof(W) / 8];
+    for (uint32_t e = 0; e < sizeof(W) / 8; e++)
+        words[e] = (j < 6) ? PATTERNS[j] : (((e >> (j - 6)) & 1) ? ~0ull : 0);
+
+    std::memcpy(&pattern, words, sizeof(W));
+}
+
+template <typename W>
+BITSLICE_INLINE void bf_mix_key(W *s, const W *k)
+{
+    #pragma GCC unroll 16
+    for (uint32_t b = 0; b < 16; b++)
+        s[b] ^= k[b];
+}
+
+template <typename W>
+BITSLICE_INLINE void bf_run(const BruteForceSpace &space, uint16_t pt, uint16_t ct, uint64_t first, uint64_t count,
+    std::vector<uint64_t> &hits)
+{
+    const uint32_t LANES = LaneTraits<W>::blocks;
+    const uint32_t LANE_BITS = __builtin_ctz(LANES);
+    const uint32_t n_unknown = space.unknown.size();
+
+    W k[SPN_SUB_KEYS][16], p[16], c[16];
+
+    for (uint32_t b = 0; b < 16; b++)
+    {
+        p[b] = W {} - ((pt >> b) & 1);
+        c[b] = W {} - ((ct >> b) & 1);
+
+        for (uint32_t i = 0; i < SPN_SUB_KEYS; i++)
+            k[i][b] = W {} - ((space.base[i] >> b) & 1);
+    }
+
+    for (uint32_t j = 0; j < std::min(LANE_BITS, n_unknown); j++)
+        bf_lane_pattern(j, k[space.unknown[j] >> 4][space.unknown[j] & 0xf]);
+
+    for (uint64_t pass = first; pass < first + count; pass += LANES)
+    {
+        for (uint32_t j = LANE_BITS; j < n_unknown; j++)
+            k[space.unknown[j] >> 4][space.unknown[j] & 0xf] = W {} - ((pass >> j) & 1);
+
+        W s[16];
+        std::memcpy(s, p, sizeof(s));
+
+        for (uint32_t rnum = 0; rnum < SPN_ROUNDS; rnum++)
+        {
+            bf_mix_key(s, k[rnum]);
+            sbox_layer<SPN_SBOX_ANF>(s);
+            perm_layer<SPN_PBOX, false>(s);
+        }
+
+        bf_mix_key(s, k[SPN_ROUNDS]);
+        sbox_layer<SPN_SBOX_ANF>(s);
+        bf_mix_key(s, k[SPN_ROUNDS + 1]);
+
+        // a lane matches when none of its 16 bits differ
+        W diff {};
+        #pragma GCC unroll 16
+        for (uint32_t b = 0; b < 16; b++)
+            diff |= s[b] ^ c[b];
+
+        uint64_t words[sizeof(W) / 8];
+        std::memcpy(words, &diff, sizeof(W));
+
+        const uint64_t left = first + count - pass;
+        for (uint32_t e = 0; e < sizeof(W) / 8; e++)
+        {
+            uint64_t match = ~words[e];
+            if (left < (e + 1) * 64)
+                match &= (left > e * 64) ? (~0ull >> (64 - (left - e * 64))) : 0;
+
+            for (; match; match &= match - 1)
+                hits.push_back(pass + e * 64 + __builtin_ctzll(match));
+        }
+    }
+}
+
+static void bf_kernel_u64(const BruteForceSpace &space, uint16_t pt, uint16_t ct, uint64_t first, uint64_t count,
+    std::vector<uint64_t> &hits)
+{
+    bf_run<Lanes64>(space, pt, ct, first, count, hits);
+}
+
+__attribute__((target("avx2")))
+static void bf_kernel_avx2(const BruteForceSpace &space, uint16_t pt, uint16_t ct, uint64_t first, uint64_t count,
+    std::vector<uint64_t> &hits)
+{
+    bf_run<Lanes256>(space, pt, ct, first, count, hits);
+}
+
+__attribute__((target("avx512f")))
+static void bf_kernel_avx512(const BruteForceSpace &space, uint16_t pt, uint16_t ct, uint64_t first, uint64_t count,
+    std::vector<uint64_t> &hits)
+{
+    bf_run<Lanes512>(space, pt, ct, first, count, hits);
+}
+
+static BFKernel bf_kernel(const char **name = nullptr)
+{
+    static const char *kernel_name = nullptr;
+    static const BFKernel selected = []() -> BFKernel {
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx512f"))
+        {
+            kernel_name = "avx512";
+            return bf_kernel_avx512;
+        }
+        if (__builtin_cpu_supports("avx2"))
+        {
+            kernel_name = "avx2";
+            return bf_kernel_avx2;
+        }
+
+        kernel_name = "u64";
+        return bf_kernel_u64;
+    }();
+
+    if (name)
+        *name = kernel_name;
+
+    return selected;
+}
+
+// one worker's share of the chunks, [begin, end)
+struct BFRange
+{
+    std::mutex lock;
+    uint64_t begin, end;
+};
+
+/*
+search `space` for keys that map every one of the n_pairs plaintexts to its
+ciphertext. n_unknown / 16 + 1 pairs are not enough for the right key to be
+the only one left: the last round works nibble by nibble, so keys that only
+differ in a nibble of the last two subkeys survive a pair with the
+probability of a differential through one sbox (up to 3/8), and the search
+wants a handful of pairs more than that.
+*/
+
+BruteForceResult bf_search(const SPN &spn, const BruteForceSpace &space, const uint16_t *pts, const uint16_t *cts,
+    size_t n_pairs, uint32_t n_threads, bool stop_early = true)
+{
+    if (!n_pairs)
+        throw std::invalid_argument("the search needs at least one known pair");
+
+    const uint64_t n_keys = 1ull << space.unknown.size();
+    const uint64_t n_chunks = (n_keys + BF_CHUNK_KEYS - 1) / BF_CHUNK_KEYS;
+    const BFKernel kernel = bf_kernel();
+
+    n_threads = std::max<uint32_t>(1, std::min<uint64_t>(n_threads, n_chunks));
+    std::vector<BFRange> ranges(n_threads);
+    for (uint32_t t = 0; t < n_threads; t++)
+    {
+        ranges[t].begin = n_chunks * t / n_threads;
+        ranges[t].end = n_chunks * (t + 1) / n_threads;
+    }
+
+    BruteForceResult result {{}, 0, 0.0, nullptr, n_threads};
+    bf_kernel(&result.kernel);
+
+    std::mutex result_lock;
+    std::atomic<bool> done(false);
+    std::atomic<uint64_t> tested(0);
+
+    // the back half of the biggest other range becomes worker t's range
+    auto steal = [&](uint32_t t) -> bool {
+        uint32_t victim = t;
+        uint64_t most = 0;
+
+        for (uint32_t v = 0; v < n_threads; v++)
+        {
+            std::lock_guard<std::mutex> guard(ranges[v].lock);
+            if ((v != t) and (ranges[v].end - ranges[v].begin > most))
+            {
+                victim = v;
+                most = ranges[v].end - ranges[v].begin;
+            }
+        }
+
+        if (victim == t)
+            return false;
+
+        uint64_t begin, end;
+        {
+            std::lock_guard<std::mutex> guard(ranges[victim].lock);
+            const uint64_t left = ranges[victim].end - ranges[victim].begin;
+            if (!left)
+                return true;    // emptied meanwhile, look again
+
+            end = ranges[victim].end;
+            begin = end - (left + 1) / 2;
+            ranges[victim].end = begin;
+        }
+
+        std::lock_guard<std::mutex> guard(ranges[t].lock);
+        ranges[t].begin = begin;
+        ranges[t].end = end;
+
+        return true;
+    };
+
+    auto work = [&](uint32_t t) {
+        std::vector<uint64_t> hits;
+        std::vector<uint16_t> check(n_pairs);
+
+        while (!done)
+        {
+            uint64_t chunk;
+            {
+                std::lock_guard<std::mutex> guard(ranges[t].lock);
+                chunk = ranges[t].begin;
+                if (chunk < ranges[t].end)
+                    ranges[t].begin++;
+                else
+                    chunk = n_chunks;
+            }
+
+            if (chunk == n_chunks)
+            {
+                if (steal(t))
+                    continue;
+
+                break;
+            }
+
+            const uint64_t first = chunk * BF_CHUNK_KEYS;
+            const uint64_t count = std::min(BF_CHUNK_KEYS, n_keys - first);
+
+            hits.clear();
+            kernel(space, pts[0], cts[0], first, count, hits);
+
+            for (const uint64_t hit: hits)
+            {
+                const std::vector<uint32_t> key = bf_candidate_key(space, hit);
+                spn.encrypt_batch(pts, check.data(), n_pairs, key);
+
+                if (!std::equal(check.begin(), check.end(), cts))
+                    continue;
+
+                std::lock_guard<std::mutex> guard(result_lock);
+                result.keys.push_back(key);
+                done = done or stop_early;
+            }
+
+            tested += count;
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> workers;
+    for (uint32_t t = 1; t < n_threads; t++)
+        workers.emplace_back(work, t);
+
+    work(0);
+
+    for (std::thread &worker: workers)
+        worker.join();
+
+    auto stop = std::chrono::steady_clock::now();
+
+    result.tested = tested;
+    result.seconds = std::chrono::duration<double>(stop - start).count();
+
+    // the same order whatever the thread count
+    std::sort(result.keys.begin(), result.keys.end());
+
+    return result;
+}
+
+#endif
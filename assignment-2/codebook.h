@@ -0,0 +1,114 @@
+#ifndef CODEBOOK_H
+#define CODEBOOK_H
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <cstdint>
+#include "spn.h"
+
+/*
+the whole codebook of one key: with a 16-bit block there are only 65536
+plaintexts, so the forward table and its inverse take 256 KiB together and
+every later encryption or decryption is a single lookup.
+
+the forward table is built with the bitsliced batch kernel, the block range
+split over worker threads. the inverse is scattered from it in the same pass,
+each thread writing the slots of its own plaintexts; since the cipher is a
+permutation no two threads touch the same slot.
+*/
+
+const uint32_t CODEBOOK_SIZE = 1 << 16;
+
+class SPNCodebook
+{
+    private:
+        std::vector<uint16_t> enc_table;
+        std::vector<uint16_t> dec_table;
+
+    public:
+        SPNCodebook(const SPN &, const SPNKey &, uint32_t = std::thread::hardware_concurrency());
+
+        uint16_t encrypt(uint32_t) const;
+        uint16_t decrypt(uint32_t) const;
+
+        std::vector<uint32_t> encrypt(const std::vector<uint32_t> &) const;
+        std::vector<uint32_t> decrypt(const std::vector<uint32_t> &) const;
+
+        void encrypt(const uint16_t *, uint16_t *, size_t) const;
+        void decrypt(const uint16_t *, uint16_t *, size_t) const;
+};
+
+SPNCodebook::SPNCodebook(const SPN &spn, const SPNKey &key, uint32_t n_threads)
+    : enc_table(CODEBOOK_SIZE), dec_table(CODEBOOK_SIZE)
+{
+    // chunks are whole multiples of the widest bitslice pass
+    const uint32_t ALIGN = LaneTraits<Lanes512>::blocks;
+    n_threads = std::max(1u, std::min(n_threads, CODEBOOK_SIZE / ALIGN));
+    const uint32_t chunk = (CODEBOOK_SIZE / n_threads + ALIGN - 1) / ALIGN * ALIGN;
+
+    auto build = [&](uint32_t begin, uint32_t end) {
+        uint16_t *enc = this->enc_table.data();
+
+        for (uint32_t pt = begin; pt < end; pt++)
+            enc[pt] = pt;
+
+        spn.encrypt_batch(enc + begin, enc + begin, end - begin, key);
+
+        for (uint32_t pt = begin; pt < end; pt++)
+            this->dec_table[enc[pt]] = pt;
+    };
+
+    std::vector<std::thread> workers;
+    for (uint32_t begin = chunk; begin < CODEBOOK_SIZE; begin += chunk)
+        workers.emplace_back(build, begin, std::min(begin + chunk, CODEBOOK_SIZE));
+
+    build(0, std::min(chunk, CODEBOOK_SIZE));
+
+    for (std::thread &worker: workers)
+        worker.join();
+}
+
+uint16_t SPNCodebook::encrypt(uint32_t pt) const
+{
+    return this->enc_table[pt & 0xffff];
+}
+
+uint16_t SPNCodebook::decrypt(uint32_t ct) const
+{
+    return this->dec_table[ct & 0xffff];
+}
+
+std::vector<uint32_t> SPNCodebook::encrypt(const std::vector<uint32_t> &pt) const
+{
+    std::vector<uint32_t> ct(pt.size());
+    for (size_t i = 0; i < pt.size(); i++)
+        ct[i] = this->enc_table[pt[i] & 0xffff];
+
+    return ct;
+}
+
+std::vector<uint32_t> SPNCodebook::decrypt(const std::vector<uint32_t> &ct) const
+{
+    std::vector<uint32_t> pt(ct.size());
+    for (size_t i = 0; i < ct.size(); i++)
+        pt[i] = this->dec_table[ct[i] & 0xffff];
+
+    return pt;
+}
+
+void SPNCodebook::encrypt(const uint16_t *pt, uint16_t *ct, size_t n) const
+{
+    const uint16_t *enc = this->enc_table.data();
+    for (size_t i = 0; i < n; i++)
+        ct[i] = enc[pt[i]];
+}
+
+void SPNCodebook::decrypt(const uint16_t *ct, uint16_t *pt, size_t n) const
+{
+    const uint16_t *dec = this->dec_table.data();
+    for (size_t i = 0; i < n; i++)
+        pt[i] = dec[ct[i]];
+}
+
+#endif
@@ -0,0 +1,143 @@
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <random>
+#include <algorithm>
+#include <unistd.h>
+#include "corpus.h"
+
+/*
+write a binary known-plaintext corpus (see corpus.h), or print the header
+of an existing one. the key is 20 hex digits or "random"; --hide-key leaves
+it out of the header. a random key is normally drawn from the seed, so the
+corpus can be rebuilt from its header; a hidden one comes from
+std::random_device instead, and the file is read back to make sure its
+header gives the key away neither directly nor through the seed.
+*/
+
+static bool parse_key(const std::string &hex, std::vector<uint32_t> &key)
+{
+    if ((hex.size() != 20) or (hex.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos))
+        return false;
+
+    key.clear();
+    for (uint32_t i = 0; i < hex.size(); i += 2)
+        key.push_back(std::stoul(hex.substr(i, 2), nullptr, 16));
+
+    return true;
+}
+
+static std::string key_hex(const std::vector<uint32_t> &key)
+{
+    std::stringstream ss;
+    for (const uint32_t byte: key)
+        ss << std::setfill('0') << std::setw(2) << std::hex << byte;
+
+    return ss.str();
+}
+
+// the random key of a corpus with the key stored
+static std::vector<uint32_t> seed_key(const SPN &spn, uint64_t seed)
+{
+    std::mt19937_64 rng(seed ^ 0x9e3779b97f4a7c15);
+    return spn.get_rand_key(rng);
+}
+
+// whether anything in the header of a hidden-key corpus leads back to `key`
+static bool key_recoverable(const SPN &spn, const SPNCorpus &corpus, const std::vector<uint32_t> &key)
+{
+    const std::vector<uint32_t> stored = corpus.key();
+    const bool stored_any = std::any_of(stored.begin(), stored.end(), [](uint32_t byte) { return byte != 0; });
+
+    return corpus.has_key() or stored_any or (seed_key(spn, corpus.seed()) == key);
+}
+
+static int usage(const char *prog)
+{
+    std::cerr << "Usage: " << prog << " <out-file> <pairs> [key (20 hex digits) | random] [threads] [seed] [--hide-key]\n";
+    std::cerr << "       " << prog << " --info <file>\n";
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    if ((argc == 3) and (std::string(argv[1]) == "--info"))
+    {
+        try
+        {
+            const SPNCorpus corpus(argv[2]);
+
+            std::cout << corpus.size() << " pairs, seed " << corpus.seed() << ", key ";
+            std::cout << (corpus.has_key() ? key_hex(corpus.key()) : "not stored") << "\n";
+        }
+        catch (const std::exception &exc)
+        {
+            std::cerr << exc.what() << "\n";
+            return 1;
+        }
+
+        return 0;
+    }
+
+    const bool store_key = (argc < 2) or (std::string(argv[argc - 1]) != "--hide-key");
+    if (!store_key)
+        argc--;
+
+    if (argc < 3)
+        return usage(argv[0]);
+
+    const SPN spn;
+    std::vector<uint32_t> key;
+    size_t n_pairs;
+    uint32_t n_threads = std::thread::hardware_concurrency();
+    uint64_t seed = std::random_device {}();
+
+    try
+    {
+        n_pairs = std::stoull(argv[2]);
+        if (argc > 4) n_threads = std::stoul(argv[4]);
+        if (argc > 5) seed = std::stoull(argv[5], nullptr, 0);
+    }
+    catch (const std::exception &)
+    {
+        return usage(argv[0]);
+    }
+
+    if ((argc < 4) or (std::string(argv[3]) == "random"))
+    {
+        std::random_device rd;
+        key = store_key ? seed_key(spn, seed) : seed_key(spn, (static_cast<uint64_t>(rd()) << 32) | rd());
+    }
+    else if (!parse_key(argv[3], key))
+        return usage(argv[0]);
+
+    auto start = std::chrono::steady_clock::now();
+
+    try
+    {
+        corpus_write(spn, key, store_key, n_pairs, seed, argv[1], n_threads);
+
+        if (!store_key and key_recoverable(spn, SPNCorpus(argv[1]), key))
+        {
+            unlink(argv[1]);
+            throw std::runtime_error(std::string("the header of ") + argv[1] + " gives the hidden key away");
+        }
+    }
+    catch (const std::exception &exc)
+    {
+        std::cerr << exc.what() << "\n";
+        return 1;
+    }
+
+    auto stop = std::chrono::steady_clock::now();
+    double secs = std::chrono::duration<double>(stop - start).count();
+
+    std::cerr << n_pairs << " pairs under key " << key_hex(key) << " (seed " << seed << ") in " << secs << " s (";
+    std::cerr << (secs > 0 ? n_pairs / secs / 1e6 : 0.0) << " M pairs/s)\n";
+
+    return 0;
+}
@@ -0,0 +1,260 @@
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <bit>
+#include <span>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <random>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "spn.h"
+
+/*
+binary known-plaintext corpus: a 64-byte header followed by all the
+plaintexts and then all the ciphertexts, each a packed array of
+little-endian uint16. keeping the two arrays apart means a mapping of the
+file hands the attacks exactly the pts / cts arrays they take, with no
+parsing or copying at all.
+
+header (little-endian):
+
+    0   magic "SPNKPC\0\0"
+    8   uint32 version (1)
+    12  uint32 flags (bit 0: the key is stored)
+    16  uint64 number of pairs n, at least 1
+    24  uint64 seed the plaintexts were drawn with
+    32  10 key bytes, zero unless flag bit 0 is set
+    42  zero padding up to 64
+
+plaintexts start at byte 64 and ciphertexts at 64 + 2n.
+
+corpus_write fills a memory mapping of the new file from worker threads,
+which take CORPUS_CHUNK_PAIRS pairs at a time; chunk c draws its plaintexts
+from a generator seeded with (seed, c), so the file does not depend on the
+number of threads.
+*/
+
+static_assert(std::endian::native == std::endian::little, "the corpus is mapped as little-endian uint16");
+
+const size_t CORPUS_HEADER_BYTES = 64;
+const size_t CORPUS_CHUNK_PAIRS = 1 << 16;
+const uint32_t CORPUS_VERSION = 1;
+const uint32_t CORPUS_HAS_KEY = 1;
+
+struct CorpusHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t n_pairs;
+    uint64_t seed;
+    uint8_t key[10];
+    uint8_t pad[22];
+};
+
+static_assert(sizeof(CorpusHeader) == CORPUS_HEADER_BYTES, "corpus header must be 64 bytes");
+
+const char CORPUS_MAGIC[8] = {'S', 'P', 'N', 'K', 'P', 'C', 0, 0};
+
+static void corpus_io_exc(const std::string &what, const char *path)
+{
+    throw std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+class SPNCorpus
+{
+    private:
+        void *map;
+        size_t map_size;
+        CorpusHeader header;
+
+    public:
+        SPNCorpus(const char *);
+        ~SPNCorpus();
+
+        SPNCorpus(const SPNCorpus &) = delete;
+        SPNCorpus &operator=(const SPNCorpus &) = delete;
+
+        size_t size(void) const;
+        uint64_t seed(void) const;
+        bool has_key(void) const;
+        std::vector<uint32_t> key(void) const;
+
+        // views straight into the mapping, valid for the lifetime of the corpus
+        std::span<const uint16_t> plaintexts(void) const;
+        std::span<const uint16_t> ciphertexts(void) const;
+};
+
+SPNCorpus::SPNCorpus(const char *path)
+    : map(MAP_FAILED), map_size(0)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        corpus_io_exc("cannot open", path);
+
+    struct stat st;
+    if (fstat(fd, &st) < 0)
+    {
+        close(fd);
+        corpus_io_exc("cannot stat", path);
+    }
+
+    this->map_size = st.st_size;
+
+    if (this->map_size < CORPUS_HEADER_BYTES)
+    {
+        close(fd);
+        throw std::runtime_error(std::string("not a corpus file: ") + path);
+    }
+
+    this->map = mmap(nullptr, this->map_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (this->map == MAP_FAILED)
+        corpus_io_exc("cannot map", path);
+
+    std::memcpy(&this->header, this->map, sizeof(CorpusHeader));
+
+    const bool valid = !std::memcmp(this->header.magic, CORPUS_MAGIC, sizeof(CORPUS_MAGIC))
+        and (this->header.version == CORPUS_VERSION)
+        and (this->header.n_pairs > 0)
+        and (this->header.n_pairs <= (this->map_size - CORPUS_HEADER_BYTES) / 4)
+        and (this->map_size == CORPUS_HEADER_BYTES + this->header.n_pairs * 4);
+
+    if (!valid)
+    {
+        munmap(this->map, this->map_size);
+        throw std::runtime_error(std::string("not a corpus file, empty or truncated: ") + path);
+    }
+
+    madvise(this->map, this->map_size, MADV_SEQUENTIAL);
+}
+
+SPNCorpus::~SPNCorpus()
+{
+    munmap(this->map, this->map_size);
+}
+
+size_t SPNCorpus::size(void) const
+{
+    return this->header.n_pairs;
+}
+
+uint64_t SPNCorpus::seed(void) const
+{
+    return this->header.seed;
+}
+
+bool SPNCorpus::has_key(void) const
+{
+    return this->header.flags & CORPUS_HAS_KEY;
+}
+
+std::vector<uint32_t> SPNCorpus::key(void) const
+{
+    return std::vector<uint32_t>(this->header.key, this->header.key + sizeof(this->header.key));
+}
+
+std::span<const uint16_t> SPNCorpus::plaintexts(void) const
+{
+    const uint8_t *base = static_cast<const uint8_t *>(this->map) + CORPUS_HEADER_BYTES;
+    return {reinterpret_cast<const uint16_t *>(base), this->size()};
+}
+
+std::span<const uint16_t> SPNCorpus::ciphertexts(void) const
+{
+    return {this->plaintexts().data() + this->size(), this->size()};
+}
+
+/*
+write n_pairs random known pairs under `key` to path. the key goes into the
+header only when store_key is set, so a corpus can also be handed out
+without the answer.
+*/
+
+void corpus_write(const SPN &spn, const std::vector<uint32_t> &key, bool store_key, size_t n_pairs,
+    uint64_t seed, const char *path, uint32_t n_threads)
+{
+    if (!n_pairs)
+        throw std::invalid_argument("a corpus needs at least one pair");
+
+    const SPNKey expanded(key);
+    const size_t size = CORPUS_HEADER_BYTES + n_pairs * 4;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        corpus_io_exc("cannot create", path);
+
+    if (ftruncate(fd, size) < 0)
+    {
+        close(fd);
+        corpus_io_exc("cannot resize", path);
+    }
+
+    void *map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (map == MAP_FAILED)
+        corpus_io_exc("cannot map", path);
+
+    CorpusHeader header {};
+    std::memcpy(header.magic, CORPUS_MAGIC, sizeof(CORPUS_MAGIC));
+    header.version = CORPUS_VERSION;
+    header.flags = store_key ? CORPUS_HAS_KEY : 0;
+    header.n_pairs = n_pairs;
+    header.seed = seed;
+
+    if (store_key)
+        for (uint32_t i = 0; i < sizeof(header.key); i++)
+            header.key[i] = key.at(i) & 0xff;
+
+    std::memcpy(map, &header, sizeof(header));
+
+    uint16_t *pts = reinterpret_cast<uint16_t *>(static_cast<uint8_t *>(map) + CORPUS_HEADER_BYTES);
+    uint16_t *cts = pts + n_pairs;
+
+    const size_t n_chunks = (n_pairs + CORPUS_CHUNK_PAIRS - 1) / CORPUS_CHUNK_PAIRS;
+    std::atomic<size_t> next(0);
+
+    auto work = [&]() {
+        for (size_t chunk; (chunk = next++) < n_chunks; )
+        {
+            const size_t begin = chunk * CORPUS_CHUNK_PAIRS;
+            const size_t n = std::min(CORPUS_CHUNK_PAIRS, n_pairs - begin);
+
+            std::seed_seq seq {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32),
+                static_cast<uint32_t>(chunk)};
+            std::mt19937_64 rng(seq);
+
+            for (size_t i = 0; i < n; i++)
+                pts[begin + i] = rng() & 0xffff;
+
+            spn.encrypt_batch(pts + begin, cts + begin, n, expanded);
+        }
+    };
+
+    n_threads = std::max<uint32_t>(1, std::min<size_t>(n_threads, n_chunks));
+    std::vector<std::thread> workers;
+    for (uint32_t t = 1; t < n_threads; t++)
+        workers.emplace_back(work);
+
+    work();
+
+    for (std::thread &worker: workers)
+        worker.join();
+
+    munmap(map, size);
+}
+
+#endif
@@ -0,0 +1,89 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <sys/stat.h>
+#include "ctr.h"
+
+/*
+encrypt or decrypt a file of any size with the SPN in counter mode. the
+key is 20 hex digits (the 10 key bytes) and the nonce a 16-bit number.
+*/
+
+static bool parse_key(const std::string &hex, std::vector<uint32_t> &key)
+{
+    if ((hex.size() != 20) or (hex.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos))
+        return false;
+
+    key.clear();
+    for (uint32_t i = 0; i < hex.size(); i += 2)
+        key.push_back(std::stoul(hex.substr(i, 2), nullptr, 16));
+
+    return true;
+}
+
+static int usage(const char *prog)
+{
+    std::cerr << "Usage: " << prog << " <key (20 hex digits)> <nonce> <in-file> <out-file> [threads]\n";
+    return 1;
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<uint32_t> key;
+    uint16_t nonce;
+    uint32_t n_threads = std::thread::hardware_concurrency();
+
+    if ((argc < 5) or !parse_key(argv[1], key))
+        return usage(argv[0]);
+
+    try
+    {
+        // the whole argument, no sign and no wrap-around onto a used nonce
+        size_t end;
+        const unsigned long value = std::stoul(argv[2], &end, 0);
+        if (!std::isdigit(static_cast<unsigned char>(argv[2][0])) or argv[2][end] or (value > 0xffff))
+            throw std::out_of_range("nonce");
+
+        nonce = value;
+        if (argc > 5) n_threads = std::stoul(argv[5]);
+    }
+    catch (const std::exception &)
+    {
+        return usage(argv[0]);
+    }
+
+    const SPN spn;
+    const SPNCounterMode ctr(spn, key, nonce);
+
+    auto start = std::chrono::steady_clock::now();
+
+    try
+    {
+        ctr_file(ctr, argv[3], argv[4], n_threads);
+    }
+    catch (const std::exception &exc)
+    {
+        std::cerr << exc.what() << "\n";
+        return 1;
+    }
+
+    auto stop = std::chrono::steady_clock::now();
+    double secs = std::chrono::duration<double>(stop - start).count();
+
+    struct stat st;
+    if (stat(argv[4], &st) < 0)
+    {
+        std::cerr << "cannot stat " << argv[4] << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    std::cerr << st.st_size << " bytes in " << secs << " s (";
+    std::cerr << (secs > 0 ? st.st_size / secs / (1 << 20) : 0.0) << " MiB/s)\n";
+
+    return 0;
+}
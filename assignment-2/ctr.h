@@ -0,0 +1,182 @@
+#ifndef CTR_H
+#define CTR_H
+
+#include <span>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "spn.h"
+
+/*
+counter mode over the SPN: block i of the keystream is E_k(nonce + i mod
+2^16), stored little-endian, and data is XORed with it byte by byte. a
+16-bit counter means the keystream repeats every 2^16 blocks (128 KiB), so
+this is a streaming exercise for the toy cipher and not a secure mode.
+
+the keystream for any byte offset is computed without state, which lets
+ctr_file cut a file into CTR_CHUNK_BYTES chunks, hand them to worker threads
+and work directly on memory mappings of both files. each worker owns one
+CTR_BUF_BLOCKS buffer, so memory use does not grow with the file size.
+*/
+
+const size_t CTR_CHUNK_BYTES = 1 << 20;
+const size_t CTR_BUF_BLOCKS = 1 << 12;
+
+class SPNCounterMode
+{
+    private:
+        const SPN &spn;
+        const SPNKey key;
+        const uint16_t nonce;
+
+    public:
+        SPNCounterMode(const SPN &, const SPNKey &, uint16_t);
+
+        // XOR in with the keystream starting at byte `offset` (even) of the stream, out may alias in
+        void apply(std::span<const uint8_t>, std::span<uint8_t>, uint64_t) const;
+};
+
+SPNCounterMode::SPNCounterMode(const SPN &spn, const SPNKey &key, uint16_t nonce)
+    : spn(spn), key(key), nonce(nonce) {}
+
+void SPNCounterMode::apply(std::span<const uint8_t> in, std::span<uint8_t> out, uint64_t offset) const
+{
+    if ((out.size() < in.size()) or (offset & 1))
+        throw std::invalid_argument("ctr output too short or offset not block aligned");
+
+    uint16_t stream[CTR_BUF_BLOCKS];
+    uint64_t block = offset >> 1;
+
+    for (size_t pos = 0; pos < in.size(); )
+    {
+        const size_t n_bytes = std::min(in.size() - pos, CTR_BUF_BLOCKS << 1);
+        const size_t n_blocks = (n_bytes + 1) >> 1;
+
+        for (size_t i = 0; i < n_blocks; i++)
+            stream[i] = this->nonce + block + i;
+
+        this->spn.encrypt_batch(stream, stream, n_blocks, this->key);
+
+        for (size_t i = 0; i < n_bytes; i++)
+            out[pos + i] = in[pos + i] ^ (stream[i >> 1] >> ((i & 1) << 3));
+
+        pos += n_bytes;
+        block += n_blocks;
+    }
+}
+
+static void ctr_io_exc(const std::string &what, const char *path)
+{
+    throw std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+/*
+encrypt (or, the same thing, decrypt) in_path into out_path, which is
+created or truncated to the same size and must not be the input file.
+*/
+
+void ctr_file(const SPNCounterMode &ctr, const char *in_path, const char *out_path, uint32_t n_threads)
+{
+    int in_fd = open(in_path, O_RDONLY);
+    if (in_fd < 0)
+        ctr_io_exc("cannot open", in_path);
+
+    struct stat st;
+    if (fstat(in_fd, &st) < 0)
+    {
+        close(in_fd);
+        ctr_io_exc("cannot stat", in_path);
+    }
+
+    const size_t size = st.st_size;
+
+    // no O_TRUNC: the output may turn out to be the input, which must stay intact
+    int out_fd = open(out_path, O_RDWR | O_CREAT, 0644);
+    if (out_fd < 0)
+    {
+        close(in_fd);
+        ctr_io_exc("cannot create", out_path);
+    }
+
+    struct stat out_st;
+    if (fstat(out_fd, &out_st) < 0)
+    {
+        close(in_fd);
+        close(out_fd);
+        ctr_io_exc("cannot stat", out_path);
+    }
+
+    if ((out_st.st_dev == st.st_dev) and (out_st.st_ino == st.st_ino))
+    {
+        close(in_fd);
+        close(out_fd);
+        throw std::invalid_argument(std::string("input and output are the same file: ") + out_path);
+    }
+
+    if (ftruncate(out_fd, size) < 0)
+    {
+        close(in_fd);
+        close(out_fd);
+        ctr_io_exc("cannot resize", out_path);
+    }
+
+    if (size == 0)
+    {
+        close(in_fd);
+        close(out_fd);
+        return;
+    }
+
+    void *in_map = mmap(nullptr, size, PROT_READ, MAP_SHARED, in_fd, 0);
+    void *out_map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, out_fd, 0);
+    close(in_fd);
+    close(out_fd);
+
+    if ((in_map == MAP_FAILED) or (out_map == MAP_FAILED))
+    {
+        if (in_map != MAP_FAILED) munmap(in_map, size);
+        if (out_map != MAP_FAILED) munmap(out_map, size);
+        ctr_io_exc("cannot map", (in_map == MAP_FAILED) ? in_path : out_path);
+    }
+
+    madvise(in_map, size, MADV_SEQUENTIAL);
+
+    const uint8_t *src = static_cast<const uint8_t *>(in_map);
+    uint8_t *dst = static_cast<uint8_t *>(out_map);
+    const size_t n_chunks = (size + CTR_CHUNK_BYTES - 1) / CTR_CHUNK_BYTES;
+    std::atomic<size_t> next(0);
+
+    auto work = [&]() {
+        for (size_t chunk; (chunk = next++) < n_chunks; )
+        {
+            const size_t begin = chunk * CTR_CHUNK_BYTES;
+            const size_t len = std::min(CTR_CHUNK_BYTES, size - begin);
+            ctr.apply({src + begin, len}, {dst + begin, len}, begin);
+        }
+    };
+
+    n_threads = std::max<uint32_t>(1, std::min<size_t>(n_threads, n_chunks));
+    std::vector<std::thread> workers;
+    for (uint32_t t = 1; t < n_threads; t++)
+        workers.emplace_back(work);
+
+    work();
+
+    for (std::thread &worker: workers)
+        worker.join();
+
+    munmap(in_map, size);
+    munmap(out_map, size);
+}
+
+#endif
@@ -0,0 +1,116 @@
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <random>
+#include "differential.h"
+#include "linear.h"
+
+/*
+differential cryptanalysis of the SPN, run next to the linear attack on the
+same random key so the data and time each one needs can be compared. both
+recover the target partial subkey [K_5,5...K_5,8, K_5,13...K_5,16].
+*/
+
+static std::string target_hex(uint32_t target)
+{
+    std::stringstream ss;
+    ss << "0x" << std::setfill('0') << std::setw(2) << std::hex << target;
+
+    return ss.str();
+}
+
+static void report(const std::string &attack, const std::string &data, uint32_t texts,
+    uint64_t work, double secs, uint32_t guess, uint32_t target)
+{
+    std::cout << std::left << std::setw(14) << attack << std::setw(8) << data;
+    std::cout << std::right << std::setw(10) << texts << std::setw(14) << work;
+    std::cout << std::setw(12) << std::fixed << std::setprecision(3) << secs * 1e3;
+    std::cout << "  " << target_hex(guess) << ((guess == target) ? " (correct)" : " (wrong)") << "\n";
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t n_pairs = 5000, n_known = 10000;
+    uint32_t n_threads = std::thread::hardware_concurrency();
+    uint64_t seed = std::random_device {}();
+
+    try
+    {
+        if (argc > 1) n_pairs = std::stoul(argv[1]);
+        if (argc > 2) n_known = std::stoul(argv[2]);
+        if (argc > 3) n_threads = std::stoul(argv[3]);
+        if (argc > 4) seed = std::stoull(argv[4], nullptr, 0);
+    }
+    catch (const std::exception &)
+    {
+        std::cerr << "Usage: " << argv[0] << " [chosen pairs] [known plaintexts] [threads] [seed]\n";
+        return 1;
+    }
+
+    const SPN spn;
+    const DifferenceDistTable ddt(spn.sbox, 4);
+
+    std::cout << "difference distribution table for a basic SPN cipher's sbox:\n";
+    std::cout << "(x-axis: output difference, y-axis: input difference)\n\n";
+
+    for (uint32_t dx = 0; dx < (1u << ddt.in_bits); dx++)
+    {
+        for (uint32_t dy = 0; dy < (1u << ddt.out_bits); dy++)
+            std::cout << std::setfill('0') << std::setw(2) << ddt.count(dx, dy) << "  ";
+
+        std::cout << "\n";
+    }
+    std::cout << std::setfill(' ');
+
+    const double prob = dca_characteristic_probability(ddt);
+    std::cout << "\ncharacteristic ΔP = 0x0b00 -> ΔU_4 = 0x0606 holds with probability ";
+    std::cout << prob << " (" << prob * 1024 << "/1024)\n";
+
+    std::mt19937_64 rng(seed);
+    const SPNKey key(spn.get_rand_key(rng));
+    const uint32_t target = lca_true_target(LCA_HEYS_APPROX, key);
+
+    std::cout << "seed " << seed << ", target partial sub_key " << target_hex(target) << "\n\n";
+
+    // differential: 2 chosen plaintexts per pair, 256 partial decryptions per filtered pair
+    auto start = std::chrono::steady_clock::now();
+    const DCACounts counts = dca_attack(spn, key, n_pairs, rng(), n_threads);
+    auto stop = std::chrono::steady_clock::now();
+    const double dca_secs = std::chrono::duration<double>(stop - start).count();
+
+    uint32_t dca_guess = 0;
+    for (uint32_t t = 0; t < DCA_TARGETS; t++)
+        if (counts[t] > counts[dca_guess]) dca_guess = t;
+
+    // linear: random known plaintexts, one histogram and three length-256 transforms
+    std::vector<uint16_t> pts(n_known), cts(n_known);
+
+    start = std::chrono::steady_clock::now();
+    for (uint16_t &pt: pts)
+        pt = rng() & 0xffff;
+
+    spn.encrypt_batch(pts.data(), cts.data(), n_known, key);
+    const LCAScores scores = lca_target_scores(LCA_HEYS_APPROX, pts.data(), cts.data(), n_known);
+    stop = std::chrono::steady_clock::now();
+    const double lca_secs = std::chrono::duration<double>(stop - start).count();
+
+    uint32_t lca_guess = 0;
+    for (uint32_t t = 0; t < scores.size(); t++)
+        if (std::abs(scores[t]) > std::abs(scores[lca_guess])) lca_guess = t;
+
+    std::cout << "right pairs for the correct target: " << counts[target];
+    std::cout << " of " << n_pairs << " (expected " << prob * n_pairs << ")\n\n";
+
+    std::cout << std::left << std::setw(14) << "attack" << std::setw(8) << "data";
+    std::cout << std::right << std::setw(10) << "texts" << std::setw(14) << "encryptions";
+    std::cout << std::setw(12) << "time (ms)" << "  guess\n";
+
+    report("differential", "chosen", n_pairs << 1, static_cast<uint64_t>(n_pairs) << 1, dca_secs, dca_guess, target);
+    report("linear", "known", n_known, n_known, lca_secs, lca_guess, target);
+
+    return !((dca_guess == target) and (lca_guess == target));
+}
@@ -0,0 +1,77 @@
+#ifndef DDT_H
+#define DDT_H
+
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+#include "lat.h"
+
+/*
+difference distribution table of any n x m sbox: entry [dx][dy] is
+#{x : S(x) ^ S(x ^ dx) = dy}, so entry / 2^n is the probability that input
+difference dx becomes output difference dy. every row sums to 2^n and the
+entries are even, since x and x ^ dx always count together.
+*/
+
+class DifferenceDistTable
+{
+    private:
+        std::vector<uint32_t> table;
+
+    public:
+        const uint32_t in_bits;
+        const uint32_t out_bits;
+
+        DifferenceDistTable(std::span<const uint8_t>, uint32_t);
+
+        uint32_t count(uint32_t, uint32_t) const;
+        double probability(uint32_t, uint32_t) const;
+
+        // largest entry over non-zero input differences
+        uint32_t max_count(void) const;
+};
+
+DifferenceDistTable::DifferenceDistTable(std::span<const uint8_t> sbox, uint32_t out_bits)
+    : in_bits(lat_log2(sbox.size())), out_bits(out_bits)
+{
+    if ((out_bits == 0) or (out_bits > 8))
+        throw std::invalid_argument("sbox output must be 1 to 8 bits");
+
+    for (const uint8_t y: sbox)
+        if (y >> out_bits)
+            throw std::invalid_argument("sbox entry wider than its output size");
+
+    const uint32_t n_in = 1 << this->in_bits, n_out = 1 << out_bits;
+    this->table.assign(n_in * n_out, 0);
+
+    for (uint32_t dx = 0; dx < n_in; dx++)
+    {
+        uint32_t *row = this->table.data() + dx * n_out;
+        for (uint32_t x = 0; x < n_in; x++)
+            row[sbox[x] ^ sbox[x ^ dx]]++;
+    }
+}
+
+uint32_t DifferenceDistTable::count(uint32_t in_diff, uint32_t out_diff) const
+{
+    return this->table.at((in_diff << this->out_bits) | out_diff);
+}
+
+double DifferenceDistTable::probability(uint32_t in_diff, uint32_t out_diff) const
+{
+    return static_cast<double>(this->count(in_diff, out_diff)) / (1 << this->in_bits);
+}
+
+uint32_t DifferenceDistTable::max_count(void) const
+{
+    const uint32_t n_out = 1 << this->out_bits;
+    uint32_t best = 0;
+
+    for (size_t i = n_out; i < this->table.size(); i++)
+        if (this->table[i] > best) best = this->table[i];
+
+    return best;
+}
+
+#endif
@@ -0,0 +1,57 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include "spn.h"
+#include "lat.h"
+#include "../assignment-3/crypto/aes.hpp"
+
+/*
+build the linear approximation table of the SPN sbox or the AES sbox (and
+their inverses), report the build time and the largest bias, and optionally
+print the whole table as CSV rows of biases, one row per input mask.
+*/
+
+int main(int argc, char *argv[])
+{
+    const std::string which = (argc > 1) ? argv[1] : "";
+    const bool dump = (argc > 2) and (std::string(argv[2]) == "--table");
+
+    const AES aes;
+    std::span<const uint8_t> sbox;
+    uint32_t out_bits;
+
+    if (which == "spn") { sbox = SPN_SBOX; out_bits = 4; }
+    else if (which == "spn-inv") { sbox = SPN_INV_SBOX; out_bits = 4; }
+    else if (which == "aes") { sbox = aes.sbox; out_bits = 8; }
+    else if (which == "aes-inv") { sbox = aes.inv_sbox; out_bits = 8; }
+    else
+    {
+        std::cerr << "Usage: " << argv[0] << " <spn|spn-inv|aes|aes-inv> [--table]\n";
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    const LinearApproxTable lat(sbox, out_bits);
+    auto stop = std::chrono::steady_clock::now();
+
+    const int32_t max_bias = lat.max_bias();
+
+    std::cerr << which << ": " << lat.in_bits << "x" << lat.out_bits << " sbox, table built in ";
+    std::cerr << std::chrono::duration<double, std::milli>(stop - start).count() << " ms, ";
+    std::cerr << "max |bias| " << max_bias << "/" << (1 << lat.in_bits) << "\n";
+
+    if (dump)
+    {
+        for (uint32_t in_mask = 0; in_mask < (1u << lat.in_bits); in_mask++)
+        {
+            for (uint32_t out_mask = 0; out_mask < (1u << lat.out_bits); out_mask++)
+                std::cout << (out_mask ? "," : "") << lat.bias(in_mask, out_mask);
+
+            std::cout << "\n";
+        }
+    }
+
+    return 0;
+}
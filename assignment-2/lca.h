@@ -0,0 +1,160 @@
+#ifndef LCA_H
+#define LCA_H
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+#include "spn.h"
+#include "linear.h"
+#include "lat.h"
+#include "trail.h"
+
+std::string bytes_to_hex(const std::vector<uint32_t> &vec, uint32_t width)
+{
+    std::stringstream ss;
+
+    for (const uint32_t &num: vec)
+        ss << std::setfill('0') << std::setw(width) << std::hex << (num | 0);
+    
+    return ss.str();
+}
+
+/*
+the linear cryptanalysis walk-through: print the sbox LAT, search the best
+three round trail, draw a random key and recover the target partial subkey
+from 10000 known plaintexts. returns whether the guess was right; all
+output goes to `out`.
+*/
+
+bool linear_cryptanalysis(std::ostream &out = std::cout)
+{
+    const SPN spn;
+
+    /* a complete enumeration of all the linear approximations of the simple SPN
+    cipher s-box. dividing an element value by 16 gives the probability bias 
+    for the particular linear combination of input and output bits.
+    */
+
+    const LinearApproxTable lat(spn.sbox, 4);
+
+    out << "linear approximation table for a basic SPN cipher's sbox:\n";
+    out << "(x-axis: output equation - 8, y-axis: input equation - 8)\n\n";
+
+    // print the linear approximation table
+    for (uint32_t in_mask = 0; in_mask < (1u << lat.in_bits); in_mask++)
+    {
+        for (uint32_t out_mask = 0; out_mask < (1u << lat.out_bits); out_mask++)
+        {
+            out << std::setfill('0') << std::setw(2);
+            out << std::dec << lat.bias(in_mask, out_mask) << "  ";
+        }
+        out << "\n";
+    }
+
+    /*
+    constructing linear approximations for the complete cipher. the trail
+    search (trail.h) chains LAT entries through the pbox and keeps the three
+    round trail with the largest bias that has at most two active sboxes in
+    the last round, so at most 8 subkey bits are guessed. let U_{i} be the
+    16-bit input of the round i sboxes and S_{i,j} the j'th sbox of round i,
+    with bits and sboxes numbered from the left. the trail it finds is
+    U_1 = 0x0006, U_2 = 0x0011, U_3 = 0x0333, U_4 = 0x7007 through
+
+        S_{1,4}:                    0x6 -> 0x3, bias +4/16
+        S_{2,3}, S_{2,4}:           0x1 -> 0x7, bias +6/16
+        S_{3,2}, S_{3,3}, S_{3,4}:  0x3 -> 0x9, bias -6/16
+
+    and by the piling-up lemma
+
+    U_{4,2} ⊕ U_{4,3} ⊕ U_{4,4} ⊕ U_{4,14} ⊕ U_{4,15} ⊕ U_{4,16}
+        ⊕ P_{14} ⊕ P_{15} ⊕ SUM(K) = 0
+
+    holds with a bias of 2^5 * (4/16) * (6/16)^2 * (-6/16)^3 = -243/4096,
+    about -0.059 against the 1/32 of the hand-derived trail in the README.
+    SUM(K) is fixed by the key, so the plaintext and U_4 bits alone agree
+    with a probability of 1/2 + 243/4096 or 1/2 - 243/4096, and partially
+    decrypting through S_{4,1} and S_{4,4} singles out those two nibbles of
+    K_5.
+    */
+
+    LinearTrailSearch search(lat, spn.pbox);
+    const LinearTrail trail = search.best(SPN_ROUNDS, 2);
+    const LinearApprox approx = trail.approx();
+
+    out << "\nbest " << SPN_ROUNDS << " round trail:";
+    for (const uint32_t mask: trail.masks)
+        out << " 0x" << bytes_to_hex({mask}, 4);
+    out << " (bias " << approx.bias << ")\n";
+
+    std::vector<uint32_t> key = spn.get_rand_key();
+    const SPNKey expanded(key);
+
+    const uint32_t k_5 = expanded.sub_keys[SPN_SUB_KEYS - 1];
+    const uint32_t target = lca_true_target(approx, expanded);
+    const uint32_t n_boxes = lca_active_sboxes(approx).size();
+
+    out << "\ntest key: " << bytes_to_hex(key, 2) << " ";
+    out << "(k_5 = 0x" << bytes_to_hex({k_5}, 4) << ")\n";
+    out << "target partial sub_key (K_5 under mask 0x" << bytes_to_hex({approx.out_mask}, 4) << "'s sboxes) = 0x";
+    out << bytes_to_hex({target}, n_boxes) << "\n\n";
+    out << "testing each target sub_key value ...\n";
+
+    // encrypt all known plaintexts in one bitsliced batch
+    std::vector<uint16_t> pts(10000), cts(10000);
+    for (uint32_t pt = 0; pt < pts.size(); pt++)
+        pts[pt] = pt;
+
+    spn.encrypt_batch(pts.data(), cts.data(), pts.size(), expanded);
+
+    /*
+    for each target partial subkey value, count the pairs for which the
+    approximation holds after partially decrypting the target ciphertext
+    nibbles (see linear.h).
+    */
+
+    const LCAScores scores = lca_target_scores(approx, pts.data(), cts.data(), pts.size());
+
+    // #(approximation holds) = (N + score) / 2
+    std::vector<uint32_t> count_target_bias(scores.size(), 0);
+    for (uint32_t t = 0; t < scores.size(); t++)
+        count_target_bias[t] = (static_cast<int64_t>(pts.size()) + scores[t]) / 2;
+
+    /*
+    the count which deviates the largest from half of the number of
+    plaintext/ciphertext samples is assumed to be the correct value.
+    */
+
+    std::vector<double> bias;
+    for (const uint32_t &l_approx: count_target_bias)
+    {
+        double laprx = static_cast<double>(l_approx);
+        laprx = fabs(laprx - 5000.0);
+        laprx /= 10000.0;
+        bias.push_back(laprx);
+    }
+
+    double max_res = 0.0;
+    uint32_t r_idx, max_idx;
+    r_idx = max_idx = 0;
+
+    for (const double &res: bias)
+    {
+        if (res > max_res)
+        {
+            max_res = res;
+            max_idx = r_idx;
+        }
+
+        r_idx++;
+    }
+
+    out << "Highest bias is " << max_res << " ";
+    out << "for sub_key value 0x" << bytes_to_hex({max_idx}, n_boxes) << "\n\n";
+
+    return max_idx == target;
+}
+
+#endif
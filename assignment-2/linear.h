@@ -0,0 +1,132 @@
+#ifndef LINEAR_H
+#define LINEAR_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "spn.h"
+#include "wht.h"
+
+/*
+last round attack with a linear approximation of the first SPN_ROUNDS
+rounds, in_mask . P ^ out_mask . U_4 = const. the sboxes of the last round
+that out_mask touches are the active ones, and the target is the K_5
+nibbles in front of them, concatenated in order (most significant first).
+
+for each target value t, lca_target_scores gives sum over pairs of
+(-1)^(approximation) when the active ciphertext nibbles are partially
+decrypted under t. the number of pairs for which it holds is (n + score) / 2
+and the target with the largest |score| is the attack's guess.
+
+the approximation only depends on the active ciphertext nibbles and the
+plaintext parity, so the pairs are folded into a signed histogram over the
+active nibble values and the scores are its XOR convolution with the
+(-1)^(U_4 parity) of every nibble value, three walsh-hadamard transforms of
+length 16^(active sboxes).
+
+the heys tutorial approximation (bit 1 is the most significant),
+
+U_{4,6} ⊕ U_{4,8} ⊕ U_{4,14} ⊕ U_{4,16} ⊕ P_{5} ⊕ P_{7} ⊕ P_{8} = 0,
+
+is LCA_HEYS_APPROX, with target [K_5,5...K_5,8, K_5,13...K_5,16].
+*/
+
+struct LinearApprox
+{
+    uint32_t in_mask;
+    uint32_t out_mask;
+    double bias;
+};
+
+const LinearApprox LCA_HEYS_APPROX {0x0b00, 0x0505, -1.0 / 32};
+
+typedef std::vector<int64_t> LCAScores;
+
+// nibble indices (0 is the least significant) of the active last-round sboxes, high to low
+std::vector<uint32_t> lca_active_sboxes(const LinearApprox &approx)
+{
+    std::vector<uint32_t> boxes;
+    for (int32_t box = 3; box >= 0; box--)
+        if ((approx.out_mask >> (box << 2)) & 0xf)
+            boxes.push_back(box);
+
+    return boxes;
+}
+
+uint32_t lca_n_targets(const LinearApprox &approx)
+{
+    return 1 << (lca_active_sboxes(approx).size() << 2);
+}
+
+// gather the nibbles of `block` in front of the active sboxes
+uint32_t lca_gather(const std::vector<uint32_t> &boxes, uint32_t block)
+{
+    uint32_t gathered = 0;
+    for (const uint32_t box: boxes)
+        gathered = (gathered << 4) | ((block >> (box << 2)) & 0xf);
+
+    return gathered;
+}
+
+uint32_t lca_true_target(const LinearApprox &approx, const SPNKey &key)
+{
+    return lca_gather(lca_active_sboxes(approx), key.sub_keys[SPN_SUB_KEYS - 1]);
+}
+
+LCAScores lca_target_scores(const LinearApprox &approx, const uint16_t *pts, const uint16_t *cts, size_t n)
+{
+    const std::vector<uint32_t> boxes = lca_active_sboxes(approx);
+    const uint32_t n_targets = 1 << (boxes.size() << 2);
+    const uint32_t u_mask = lca_gather(boxes, approx.out_mask);
+
+    LCAScores hist(n_targets, 0), signs(n_targets);
+
+    for (size_t i = 0; i < n; i++)
+    {
+        uint32_t parity = __builtin_popcount(pts[i] & approx.in_mask) & 1;
+        hist[lca_gather(boxes, cts[i])] += parity ? -1 : 1;
+    }
+
+    for (uint32_t v = 0; v < n_targets; v++)
+    {
+        uint32_t u = 0;
+        for (uint32_t nib = 0; nib < boxes.size(); nib++)
+            u |= SPN_INV_SBOX[(v >> (nib << 2)) & 0xf] << (nib << 2);
+
+        signs[v] = (__builtin_popcount(u & u_mask) & 1) ? -1 : 1;
+    }
+
+    fwht(hist.data(), hist.size());
+    fwht(signs.data(), signs.size());
+    for (uint32_t i = 0; i < n_targets; i++)
+        hist[i] *= signs[i];
+    fwht(hist.data(), hist.size());
+
+    // the inverse transform divides by the length
+    for (int64_t &score: hist)
+        score /= static_cast<int64_t>(n_targets);
+
+    return hist;
+}
+
+/*
+rank of a target among all candidates ordered by |score|, 1 being the best.
+ties are counted against the target, so rank 1 means a unique best guess.
+*/
+
+uint32_t lca_rank(const LCAScores &scores, uint32_t target)
+{
+    const int64_t mine = scores[target] < 0 ? -scores[target] : scores[target];
+    uint32_t rank = 1;
+
+    for (uint32_t t = 0; t < scores.size(); t++)
+    {
+        const int64_t other = scores[t] < 0 ? -scores[t] : scores[t];
+        if ((t != target) and (other >= mine))
+            rank++;
+    }
+
+    return rank;
+}
+
+#endif
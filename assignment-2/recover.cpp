@@ -0,0 +1,165 @@
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <random>
+#include <memory>
+#include <algorithm>
+#include "recovery.h"
+#include "corpus.h"
+
+/*
+recover the whole 80-bit key of a random SPN key, or the key behind a
+corpus file (corpus.h), from known pairs with the multiple-approximation
+attack of recovery.h, printing for every stage the approximations used, the
+subkey found, the rank of the true subkey (when the key is known) and the
+time taken.
+*/
+
+static std::string hex(uint32_t value, uint32_t width)
+{
+    std::stringstream ss;
+    ss << std::setfill('0') << std::setw(width) << std::hex << value;
+
+    return ss.str();
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t n_pairs = 100000;
+    uint32_t n_threads = std::thread::hardware_concurrency();
+    uint64_t seed = std::random_device {}();
+    const char *corpus_path = ((argc > 2) and (std::string(argv[1]) == "--corpus")) ? argv[2] : nullptr;
+
+    try
+    {
+        if (corpus_path)
+        {
+            if (argc > 3) n_threads = std::stoul(argv[3]);
+        }
+        else
+        {
+            if (argc > 1) n_pairs = std::stoul(argv[1]);
+            if (argc > 2) n_threads = std::stoul(argv[2]);
+            if (argc > 3) seed = std::stoull(argv[3], nullptr, 0);
+
+            if (!n_pairs)
+                throw std::invalid_argument("no known pairs");
+        }
+    }
+    catch (const std::exception &)
+    {
+        std::cerr << "Usage: " << argv[0] << " [known pairs] [threads] [seed]\n";
+        std::cerr << "       " << argv[0] << " --corpus <file> [threads]\n";
+        return 1;
+    }
+
+    const SPN spn;
+    std::vector<uint32_t> key;
+    std::vector<uint16_t> own_pts, own_cts;
+    std::span<const uint16_t> pts, cts;
+    std::unique_ptr<SPNCorpus> corpus;
+
+    if (corpus_path)
+    {
+        try
+        {
+            corpus = std::make_unique<SPNCorpus>(corpus_path);
+        }
+        catch (const std::exception &exc)
+        {
+            std::cerr << exc.what() << "\n";
+            return 1;
+        }
+
+        pts = corpus->plaintexts();
+        cts = corpus->ciphertexts();
+        if (corpus->has_key())
+            key = corpus->key();
+
+        std::cout << corpus_path << ", " << pts.size() << " known pairs\n";
+    }
+    else
+    {
+        std::mt19937_64 rng(seed);
+        key = spn.get_rand_key(rng);
+
+        own_pts.resize(n_pairs);
+        own_cts.resize(n_pairs);
+        for (uint16_t &pt: own_pts)
+            pt = rng() & 0xffff;
+
+        spn.encrypt_batch(own_pts.data(), own_cts.data(), n_pairs, key);
+        pts = own_pts;
+        cts = own_cts;
+
+        std::cout << "seed " << seed << ", " << n_pairs << " known pairs\n";
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<RecoveryStage> stages;
+    std::vector<uint32_t> found;
+
+    try
+    {
+        found = rec_recover_key(spn, pts.data(), cts.data(), pts.size(), n_threads, stages);
+    }
+    catch (const std::exception &exc)
+    {
+        std::cerr << exc.what() << "\n";
+        return 1;
+    }
+
+    auto stop = std::chrono::steady_clock::now();
+
+    for (const RecoveryStage &stage: stages)
+    {
+        const uint32_t idx = stage.rounds + 1;
+
+        std::cout << "\n" << stage.rounds << " round" << (stage.rounds == 1 ? "" : "s");
+        std::cout << " before K_" << idx + 1 << ", " << stage.approxes.size() << " approximations:\n";
+
+        if (stage.rounds)
+        {
+            for (const LinearApprox &approx: stage.approxes)
+            {
+                std::cout << "    0x" << hex(approx.in_mask, 4) << " -> 0x" << hex(approx.out_mask, 4);
+                std::cout << "  bias " << approx.bias << "\n";
+            }
+        }
+
+        std::cout << "    found 0x" << hex(stage.sub_key, 4);
+
+        if (!key.empty())
+        {
+            const SPNKey expanded(key);
+            const uint32_t truth = (idx == SPN_SUB_KEYS - 1)
+                ? expanded.sub_keys[idx] : rec_inv_permute(expanded.sub_keys[idx]);
+
+            std::cout << ", true 0x" << hex(truth, 4) << " (rank " << rec_rank(stage.joint, truth) << ")";
+        }
+
+        std::cout << "\n";
+    }
+
+    std::string found_hex, key_hex;
+    for (uint32_t i = 0; i < found.size(); i++)
+        found_hex += hex(found[i], 2);
+    for (uint32_t i = 0; i < key.size(); i++)
+        key_hex += hex(key[i], 2);
+
+    std::cout << "\nrecovered key " << found_hex << ", true key " << (key.empty() ? "unknown" : key_hex) << " ";
+    std::cout << "(" << std::chrono::duration<double, std::milli>(stop - start).count() << " ms)\n";
+
+    // the recovered key has to reproduce every known pair
+    std::vector<uint16_t> check(pts.size());
+    spn.encrypt_batch(pts, check, SPNKey(found));
+
+    const bool ok = std::equal(check.begin(), check.end(), cts.begin(), cts.end());
+    std::cout << (ok ? "Success!\n" : "Failure\n");
+
+    return !ok;
+}
@@ -0,0 +1,221 @@
+#ifndef RECOVERY_H
+#define RECOVERY_H
+
+#include <array>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+#include "spn.h"
+#include "linear.h"
+#include "trail.h"
+
+/*
+full key recovery with multiple linear approximations, one round at a time.
+
+a stage attacks a cipher of R full rounds followed by a key mixing, an sbox
+layer and a last key mixing K, starting with the SPN itself (R = SPN_ROUNDS,
+K = K_5). for every group of at most two last-round sboxes it takes the best
+R round trail whose active sboxes lie in that group, and the same for every
+output mask of a single sbox: one mask per sbox leaves candidates that the
+inverse sbox cannot tell apart (linear structures of m.S^-1), several masks
+do not. each approximation's own target nibbles are scored with the
+histogram / WHT method of linear.h. the groups are scored in parallel, one
+worker thread per approximation at a time.
+
+the 2^16 candidates for K are then ranked jointly. for the right key the
+score of approximation i is about 2 * bias_i * n, for a wrong one it is
+noise of size sqrt(n), so each candidate gets
+
+sum_i bias_i^2 * score_i(its nibbles)^2 / n
+
+(the small-bias log-likelihood ratio when the sign of each bias is not
+known) and the best one is taken as K.
+
+peeling the last round off every ciphertext, c -> P^-1(S^-1(c ^ K)), leaves
+a cipher of the same shape with R - 1 full rounds whose last key is
+P^-1(K_{R+1}), so the next stage attacks that with shorter (and much
+stronger) trails. at R = 0 what is left is c = S(p ^ K_1) ^ P^-1(K_2), and
+the approximations are the 60 single-sbox masks m.U_1 = m.P ^ m.K_1, each
+with bias 1/2. K_1 then follows from any one pair.
+*/
+
+const uint32_t REC_CANDIDATES = 1 << 16;
+
+struct RecoveryStage
+{
+    uint32_t rounds;
+    std::vector<LinearApprox> approxes;
+    uint32_t sub_key;                   // K, in the peeled domain
+    std::vector<double> joint;          // joint score of every candidate
+};
+
+uint32_t rec_inv_permute(uint32_t state)
+{
+    uint32_t permuted = 0;
+    for (uint32_t bit = 0; bit < 16; bit++)
+        permuted |= ((state >> SPN_PBOX[bit]) & 1) << bit;
+
+    return permuted;
+}
+
+// the approximations of a stage with `rounds` full rounds
+std::vector<LinearApprox> rec_stage_approxes(LinearTrailSearch &search, uint32_t rounds, uint32_t n_threads)
+{
+    std::vector<LinearApprox> approxes;
+
+    if (rounds == 0)
+    {
+        for (uint32_t box = 0; box < 4; box++)
+            for (uint32_t m = 1; m < 16; m++)
+                approxes.push_back({m << (box << 2), m << (box << 2), 0.5});
+
+        return approxes;
+    }
+
+    // sbox groups, then every mask of a single sbox
+    std::vector<uint32_t> allowed;
+    for (uint32_t group = 1; group < 16; group++)
+    {
+        uint32_t bits = 0;
+        for (uint32_t box = 0; box < 4; box++)
+            if ((group >> box) & 1) bits |= 0xf << (box << 2);
+
+        if (__builtin_popcount(group) <= 2)
+            allowed.push_back(bits);
+    }
+
+    for (uint32_t box = 0; box < 4; box++)
+        for (uint32_t m = 1; m < 16; m++)
+            allowed.push_back(m << (box << 2));
+
+    for (const uint32_t bits: allowed)
+    {
+        const LinearApprox approx = search.best_within(rounds, bits, n_threads).approx();
+
+        bool seen = false;
+        for (const LinearApprox &other: approxes)
+            seen |= (other.in_mask == approx.in_mask) and (other.out_mask == approx.out_mask);
+
+        if (!seen)
+            approxes.push_back(approx);
+    }
+
+    return approxes;
+}
+
+std::vector<double> rec_joint_scores(const std::vector<LinearApprox> &approxes,
+    const uint16_t *pts, const uint16_t *cts, size_t n, uint32_t n_threads)
+{
+    std::vector<LCAScores> scores(approxes.size());
+    std::atomic<uint32_t> next(0);
+
+    auto score = [&]() {
+        for (uint32_t i; (i = next++) < approxes.size(); )
+            scores[i] = lca_target_scores(approxes[i], pts, cts, n);
+    };
+
+    n_threads = std::max(1u, std::min<uint32_t>(n_threads, approxes.size()));
+    std::vector<std::thread> workers;
+    for (uint32_t t = 1; t < n_threads; t++)
+        workers.emplace_back(score);
+
+    score();
+
+    for (std::thread &worker: workers)
+        worker.join();
+
+    std::vector<double> joint(REC_CANDIDATES, 0.0);
+
+    for (uint32_t i = 0; i < approxes.size(); i++)
+    {
+        const std::vector<uint32_t> boxes = lca_active_sboxes(approxes[i]);
+        const double weight = approxes[i].bias * approxes[i].bias / n;
+
+        for (uint32_t k = 0; k < REC_CANDIDATES; k++)
+        {
+            const double s = static_cast<double>(scores[i][lca_gather(boxes, k)]);
+            joint[k] += weight * s * s;
+        }
+    }
+
+    return joint;
+}
+
+// rank of a candidate by joint score, 1 being the best and ties counted against it
+uint32_t rec_rank(const std::vector<double> &joint, uint32_t candidate)
+{
+    uint32_t rank = 1;
+    for (uint32_t k = 0; k < joint.size(); k++)
+        rank += (k != candidate) and (joint[k] >= joint[candidate]);
+
+    return rank;
+}
+
+// c -> P^-1(S^-1(c ^ sub_key)) for every ciphertext
+void rec_peel(uint16_t *cts, size_t n, uint32_t sub_key)
+{
+    std::array<uint16_t, 1 << 16> table;
+    for (uint32_t c = 0; c < (1 << 16); c++)
+    {
+        uint32_t x = c ^ sub_key, u = 0;
+        for (uint32_t box = 0; box < 4; box++)
+            u |= SPN_INV_SBOX[(x >> (box << 2)) & 0xf] << (box << 2);
+
+        table[c] = rec_inv_permute(u);
+    }
+
+    for (size_t i = 0; i < n; i++)
+        cts[i] = table[cts[i]];
+}
+
+/*
+recover all five subkeys from n known pairs. `stages` receives the
+intermediate results, outermost round first; the returned key is in the
+byte layout of SPN::get_rand_key.
+*/
+
+std::vector<uint32_t> rec_recover_key(const SPN &spn, const uint16_t *pts, const uint16_t *cts, size_t n,
+    uint32_t n_threads, std::vector<RecoveryStage> &stages)
+{
+    if (!n)
+        throw std::invalid_argument("key recovery needs at least one known pair");
+
+    LinearTrailSearch search(LinearApproxTable(spn.sbox, 4), spn.pbox);
+    std::vector<uint16_t> peeled(cts, cts + n);
+    std::array<uint32_t, SPN_SUB_KEYS> sub_keys {};
+
+    stages.clear();
+
+    for (int32_t rounds = SPN_ROUNDS; rounds >= 0; rounds--)
+    {
+        RecoveryStage stage;
+        stage.rounds = rounds;
+        stage.approxes = rec_stage_approxes(search, rounds, n_threads);
+        stage.joint = rec_joint_scores(stage.approxes, pts, peeled.data(), n, n_threads);
+        stage.sub_key = std::max_element(stage.joint.begin(), stage.joint.end()) - stage.joint.begin();
+
+        // K_{R+2} is P(K) for every peeled stage
+        const uint32_t idx = rounds + 1;
+        sub_keys[idx] = (idx == SPN_SUB_KEYS - 1) ? stage.sub_key : spn_permute(stage.sub_key);
+
+        rec_peel(peeled.data(), n, stage.sub_key);
+        stages.push_back(std::move(stage));
+    }
+
+    // the last peel leaves P^-1(U_1), and U_1 = P ^ K_1
+    sub_keys[0] = pts[0] ^ spn_permute(peeled[0]);
+
+    std::vector<uint32_t> key;
+    for (const uint32_t k: sub_keys)
+    {
+        key.push_back(k >> 8);
+        key.push_back(k & 0xff);
+    }
+
+    return key;
+}
+
+#endif
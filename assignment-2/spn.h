@@ -1,43 +1,280 @@
+#ifndef SPN_H
+#define SPN_H
+
 #include <vector>
-#include <map>
+#include <array>
+#include <span>
+#include <random>
+#include <stdexcept>
+#include <cstdint>
 #include <cstdlib>
 #include <ctime>
+#include "bitslice.h"
+
+/*
+the round function P(S(x)) only mixes bits within a nibble before the bit
+permutation, and the permutation is linear, so it splits over the two bytes
+of the state: P(S(x)) = T[0][x & 0xff] ^ T[1][x >> 8]. the same holds for the
+inverse direction P(S^-1(x)), which lets decryption carry the state in the
+permuted domain and XOR P(k) instead of k. all tables are key independent
+and built at compile time.
+*/
+
+typedef std::array<std::array<uint16_t, 256>, 2> RoundTable;
+
+constexpr std::array<uint8_t, 16> SPN_SBOX {
+    0xe, 0x4, 0xd, 0x1, 0x2, 0xf, 0xb, 0x8,
+    0x3, 0xa, 0x6, 0xc, 0x5, 0x9, 0x0, 0x7
+};
+
+constexpr std::array<uint8_t, 16> SPN_PBOX {
+    0x0, 0x4, 0x8, 0xc, 0x1, 0x5, 0x9, 0xd,
+    0x2, 0x6, 0xa, 0xe, 0x3, 0x7, 0xb, 0xf
+};
+
+constexpr std::array<uint8_t, 16> invert_sbox(const std::array<uint8_t, 16> &sbox)
+{
+    std::array<uint8_t, 16> inv {};
+    for (uint32_t i = 0; i < 16; i++)
+        inv[sbox[i]] = i;
+
+    return inv;
+}
+
+constexpr std::array<uint8_t, 16> SPN_INV_SBOX = invert_sbox(SPN_SBOX);
+
+// bit i of the state moves to bit pbox[i]
+constexpr uint16_t spn_permute(uint32_t state)
+{
+    uint16_t permuted = 0;
+    for (uint32_t bit = 0; bit < 16; bit++)
+        permuted |= ((state >> bit) & 1) << SPN_PBOX[bit];
+
+    return permuted;
+}
+
+// entry [h][b] is byte b substituted nibble-wise, placed in byte h and optionally permuted
+constexpr RoundTable make_round_table(const std::array<uint8_t, 16> &sbox, bool permute)
+{
+    RoundTable table {};
+
+    for (uint32_t half = 0; half < 2; half++)
+    {
+        for (uint32_t byte = 0; byte < 256; byte++)
+        {
+            uint32_t sub = (sbox[byte & 0xf] | (sbox[byte >> 4] << 4)) << (half << 3);
+            table[half][byte] = permute ? spn_permute(sub) : sub;
+        }
+    }
+
+    return table;
+}
+
+constexpr RoundTable SPN_ENC_ROUND = make_round_table(SPN_SBOX, true);
+constexpr RoundTable SPN_ENC_FINAL = make_round_table(SPN_SBOX, false);
+constexpr RoundTable SPN_DEC_ROUND = make_round_table(SPN_INV_SBOX, true);
+constexpr RoundTable SPN_DEC_FINAL = make_round_table(SPN_INV_SBOX, false);
+
+constexpr std::array<uint16_t, 4> SPN_SBOX_ANF = sbox_anf(SPN_SBOX);
+constexpr std::array<uint16_t, 4> SPN_INV_SBOX_ANF = sbox_anf(SPN_INV_SBOX);
+
+/*
+bitsliced batch kernels: the same rounds as SPN::encrypt / SPN::decrypt on
+LaneTraits<W>::blocks blocks per pass. a short last pass is padded through a
+scratch buffer. they are compiled for plain 64-bit words, AVX2 and AVX-512
+and spn_batch_kernel() picks the widest one the cpu supports.
+*/
+
+typedef void (*SPNBatchKernel)(const uint16_t *, uint16_t *, size_t, const uint32_t *, uint32_t);
+
+template <typename W>
+BITSLICE_INLINE void spn_mix_key(W *s, uint32_t sub_key)
+{
+    #pragma GCC unroll 16
+    for (uint32_t b = 0; b < 16; b++)
+        s[b] ^= W {} - ((sub_key >> b) & 1); // all ones where the key bit is set
+}
+
+template <typename W, bool DECRYPT>
+BITSLICE_INLINE void spn_bitslice_run(const uint16_t *in, uint16_t *out, size_t n, const uint32_t *sub_keys, uint32_t rounds)
+{
+    const uint32_t LANES = LaneTraits<W>::blocks;
+    alignas(64) uint16_t tail[LANES];
+
+    for (size_t i = 0; i < n; i += LANES)
+    {
+        const size_t count = (n - i < LANES) ? n - i : LANES;
+        const uint16_t *src = in + i;
+
+        if (count < LANES)
+        {
+            std::memset(tail, 0, sizeof(tail));
+            std::memcpy(tail, src, count * sizeof(uint16_t));
+            src = tail;
+        }
+
+        W s[16];
+        bitslice_load(src, s);
+
+        if (!DECRYPT)
+        {
+            for (uint32_t rnum = 0; rnum < rounds; rnum++)
+            {
+                spn_mix_key(s, sub_keys[rnum]);
+                sbox_layer<SPN_SBOX_ANF>(s);
+                perm_layer<SPN_PBOX, false>(s);
+            }
+
+            spn_mix_key(s, sub_keys[rounds]);
+            sbox_layer<SPN_SBOX_ANF>(s);
+            spn_mix_key(s, sub_keys[rounds + 1]);
+        }
+        else
+        {
+            spn_mix_key(s, sub_keys[rounds + 1]);
+            sbox_layer<SPN_INV_SBOX_ANF>(s);
+
+            for (uint32_t rnum = rounds; rnum > 0; rnum--)
+            {
+                spn_mix_key(s, sub_keys[rnum]);
+                perm_layer<SPN_PBOX, true>(s);
+                sbox_layer<SPN_INV_SBOX_ANF>(s);
+            }
+
+            spn_mix_key(s, sub_keys[0]);
+        }
+
+        if (count < LANES)
+        {
+            bitslice_store(s, tail);
+            std::memcpy(out + i, tail, count * sizeof(uint16_t));
+        }
+        else
+            bitslice_store(s, out + i);
+    }
+}
+
+template <bool DECRYPT>
+static void spn_batch_u64(const uint16_t *in, uint16_t *out, size_t n, const uint32_t *sub_keys, uint32_t rounds)
+{
+    spn_bitslice_run<Lanes64, DECRYPT>(in, out, n, sub_keys, rounds);
+}
+
+template <bool DECRYPT>
+__attribute__((target("avx2")))
+static void spn_batch_avx2(const uint16_t *in, uint16_t *out, size_t n, const uint32_t *sub_keys, uint32_t rounds)
+{
+    spn_bitslice_run<Lanes256, DECRYPT>(in, out, n, sub_keys, rounds);
+}
+
+template <bool DECRYPT>
+__attribute__((target("avx512f")))
+static void spn_batch_avx512(const uint16_t *in, uint16_t *out, size_t n, const uint32_t *sub_keys, uint32_t rounds)
+{
+    spn_bitslice_run<Lanes512, DECRYPT>(in, out, n, sub_keys, rounds);
+}
+
+static SPNBatchKernel spn_batch_kernel(bool decrypt, const char **name = nullptr)
+{
+    static const char *kernel_name = nullptr;
+    static const SPNBatchKernel kernels[2] = {
+        spn_batch_u64<false>, spn_batch_u64<true>
+    };
+    static const SPNBatchKernel *selected = []() -> const SPNBatchKernel * {
+        static const SPNBatchKernel avx512[2] = {
+            spn_batch_avx512<false>, spn_batch_avx512<true>
+        };
+        static const SPNBatchKernel avx2[2] = {
+            spn_batch_avx2<false>, spn_batch_avx2<true>
+        };
+
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx512f"))
+        {
+            kernel_name = "avx512";
+            return avx512;
+        }
+        if (__builtin_cpu_supports("avx2"))
+        {
+            kernel_name = "avx2";
+            return avx2;
+        }
+
+        kernel_name = "u64";
+        return kernels;
+    }();
+
+    if (name)
+        *name = kernel_name;
+
+    return selected[decrypt];
+}
+
+/*
+the expanded key: the five 16-bit subkeys read big-endian from the ten key
+bytes, and the copy decryption uses with the middle three permuted. it is
+derived once and accepted by every encryption path; a plain key vector
+still converts to it implicitly, at the cost of one derivation per call.
+*/
+
+const uint32_t SPN_ROUNDS = 3;
+const uint32_t SPN_SUB_KEYS = SPN_ROUNDS + 2;
+
+class SPNKey
+{
+    public:
+        std::array<uint32_t, SPN_SUB_KEYS> sub_keys;
+        std::array<uint32_t, SPN_SUB_KEYS> dec_keys;
+
+        SPNKey(const std::vector<uint32_t> &);
+};
+
+SPNKey::SPNKey(const std::vector<uint32_t> &key)
+{
+    for (uint32_t i = 0; i < SPN_SUB_KEYS; i++)
+        this->sub_keys[i] = ((key.at(i << 1) & 0xff) << 8) | (key.at((i << 1) + 1) & 0xff);
+
+    this->dec_keys = this->sub_keys;
+    for (uint32_t rnum = 1; rnum <= SPN_ROUNDS; rnum++)
+        this->dec_keys[rnum] = spn_permute(this->sub_keys[rnum]);
+}
 
 class SPN
 {
     private:
-        uint32_t apply_sbox(uint32_t, bool) const;
-        std::vector<uint32_t> get_sub_keys(const std::vector<uint32_t> &) const;
+        static uint32_t apply_round(const RoundTable &, uint32_t);
 
     public:
         const uint32_t block_size, key_size, rounds;
-        const std::map<uint32_t, uint32_t> sbox;
-        const std::map<uint32_t, uint32_t> inv_sbox;
-        const std::map<uint32_t, uint32_t> pbox;
+        static constexpr std::array<uint8_t, 16> sbox = SPN_SBOX;
+        static constexpr std::array<uint8_t, 16> inv_sbox = SPN_INV_SBOX;
+        static constexpr std::array<uint8_t, 16> pbox = SPN_PBOX;
 
         SPN(void);
         std::vector<uint32_t> get_rand_key(void) const;
-        std::vector<uint32_t> encrypt(const std::vector<uint32_t>, std::vector<uint32_t> &) const;
-        std::vector<uint32_t> decrypt(const std::vector<uint32_t>, std::vector<uint32_t> &) const;
+        std::vector<uint32_t> get_rand_key(std::mt19937_64 &) const;
+        std::vector<uint32_t> encrypt(const std::vector<uint32_t> &, const SPNKey &) const;
+        std::vector<uint32_t> decrypt(const std::vector<uint32_t> &, const SPNKey &) const;
+
+        // out-param versions, out must hold at least in.size() blocks and may alias in
+        void encrypt(std::span<const uint32_t>, std::span<uint32_t>, const SPNKey &) const;
+        void decrypt(std::span<const uint32_t>, std::span<uint32_t>, const SPNKey &) const;
+
+        // bitsliced, many blocks per pass; in and out may be the same buffer
+        void encrypt_batch(const uint16_t *, uint16_t *, size_t, const SPNKey &) const;
+        void decrypt_batch(const uint16_t *, uint16_t *, size_t, const SPNKey &) const;
+        void encrypt_batch(std::span<const uint16_t>, std::span<uint16_t>, const SPNKey &) const;
+        void decrypt_batch(std::span<const uint16_t>, std::span<uint16_t>, const SPNKey &) const;
 };
 
+static void short_output_exc(void)
+{
+    throw std::invalid_argument("output span is shorter than the input");
+}
+
 SPN::SPN(void)
-    : block_size(16), key_size(10), rounds(3), sbox({
-        {0x0, 0xe}, {0x1, 0x4}, {0x2, 0xd}, {0x3, 0x1},
-        {0x4, 0x2}, {0x5, 0xf}, {0x6, 0xb}, {0x7, 0x8},
-        {0x8, 0x3}, {0x9, 0xa}, {0xa, 0x6}, {0xb, 0xc},
-        {0xc, 0x5}, {0xd, 0x9}, {0xe, 0x0}, {0xf, 0x7}
-    }), inv_sbox({
-        {0xe, 0x0}, {0x4, 0x1}, {0xd, 0x2}, {0x1, 0x3},
-        {0x2, 0x4}, {0xf, 0x5}, {0xb, 0x6}, {0x8, 0x7},
-        {0x3, 0x8}, {0xa, 0x9}, {0x6, 0xa}, {0xc, 0xb},
-        {0x5, 0xc}, {0x9, 0xd}, {0x0, 0xe}, {0x7, 0xf}
-    }), pbox({
-        {0x0, 0x0}, {0x1, 0x4}, {0x2, 0x8}, {0x3, 0xc},
-        {0x4, 0x1}, {0x5, 0x5}, {0x6, 0x9}, {0x7, 0xd},
-        {0x8, 0x2}, {0x9, 0x6}, {0xa, 0xa}, {0xb, 0xe},
-        {0xc, 0x3}, {0xd, 0x7}, {0xe, 0xb}, {0xf, 0xf}
-    }) {}
+    : block_size(16), key_size(10), rounds(SPN_ROUNDS) {}
 
 std::vector<uint32_t> SPN::get_rand_key(void) const
 {
@@ -46,150 +283,111 @@ std::vector<uint32_t> SPN::get_rand_key(void) const
 
     for (uint32_t i = 0; i < this->key_size; i++)
         key[i] = abs(static_cast<uint32_t>(std::rand())) & 0xff;
-    
+
     return key;
 }
 
-uint32_t SPN::apply_sbox(uint32_t state, bool inv) const
+// reproducible keys, one generator per thread
+std::vector<uint32_t> SPN::get_rand_key(std::mt19937_64 &rng) const
 {
-    std::vector<uint32_t> sub_states {
-        (state & 0x000f),
-        (state & 0x00f0) >> 4,
-        (state & 0x0f00) >> 8,
-        (state & 0xf000) >> 12
-    };
-
-    uint32_t index = 0;
-
-    for (const uint32_t &sub_state: sub_states)
-    {
-        if (inv) sub_states[index] = this->inv_sbox.at(sub_state);
-        else sub_states[index] = this->sbox.at(sub_state);
-        index++;
-    }
-
-    uint32_t new_state = 0, shift = 0;
+    std::vector<uint32_t> key(this->key_size, 0);
 
-    for (const uint32_t &sub_state: sub_states)
-    {
-        new_state |= (sub_state << shift);
-        shift += 4;
-    }
+    for (uint32_t i = 0; i < this->key_size; i++)
+        key[i] = rng() & 0xff;
 
-    return new_state;
+    return key;
 }
 
-std::vector<uint32_t> SPN::get_sub_keys(const std::vector<uint32_t> &key) const
+uint32_t SPN::apply_round(const RoundTable &table, uint32_t state)
 {
-    std::vector<uint32_t> sub_keys;
+    return table[0][state & 0xff] ^ table[1][state >> 8];
+}
 
-    {
-        uint32_t key_idx = 0;
-        uint32_t sub_key;
+std::vector<uint32_t> SPN::encrypt(const std::vector<uint32_t> &pt, const SPNKey &key) const
+{
+    std::vector<uint32_t> ct(pt.size());
+    this->encrypt(pt, ct, key);
 
-        while (key_idx < key.size())
-        {
-            sub_key = key[key_idx];
-            sub_key <<= 8;
-            sub_key += key[key_idx + 1];
+    return ct;
+}
 
-            sub_keys.push_back(sub_key);
-            key_idx += 2;
-        }
-    }
+std::vector<uint32_t> SPN::decrypt(const std::vector<uint32_t> &ct, const SPNKey &key) const
+{
+    std::vector<uint32_t> pt(ct.size());
+    this->decrypt(ct, pt, key);
 
-    return sub_keys;
+    return pt;
 }
 
-std::vector<uint32_t> SPN::encrypt(const std::vector<uint32_t> pt, std::vector<uint32_t> &key) const
+void SPN::encrypt(std::span<const uint32_t> pt, std::span<uint32_t> ct, const SPNKey &key) const
 {
-    std::vector<uint32_t> sub_keys = this->get_sub_keys(key);
+    if (ct.size() < pt.size())
+        short_output_exc();
 
-    std::vector<uint32_t> ct;
-    uint32_t state_temp, bit_idx;
+    const std::array<uint32_t, SPN_SUB_KEYS> &sub_keys = key.sub_keys;
 
-    for (uint32_t state: pt)
+    for (size_t i = 0; i < pt.size(); i++)
     {
-        // first three rounds of sinple SPN cipher
-        for (uint32_t rnum = 0; rnum < this->rounds; rnum++)
-        {
-            // XOR state with round key (3, subkeys 1, ..., 4)
-            state ^= sub_keys[rnum];
-
-            // break state into nibbles, perform sbox on each nibble, write to state (1)
-            state = this->apply_sbox(state, false);
+        uint32_t state = pt[i] & 0xffff;
 
-            // permute the state bitwise (2)
-            state_temp = bit_idx = 0;
-            while (bit_idx < this->block_size)
-            {
-                if (state & (1 << bit_idx))
-                {
-                    state_temp |= (1 << this->pbox.at(bit_idx));
-                }
-
-                bit_idx++;
-            }
-
-            state = state_temp;
-        }
+        // first three rounds of simple SPN cipher: key mixing, then sbox and permutation fused
+        for (uint32_t rnum = 0; rnum < this->rounds; rnum++)
+            state = apply_round(SPN_ENC_ROUND, state ^ sub_keys[rnum]);
 
         // final round of SPN cipher (k4, sbox, s5)
-        state ^= *(sub_keys.rbegin() + 1); // penultimate subkey (key 4) mixing
-        state = this->apply_sbox(state, false);
-        state ^= *(sub_keys.rbegin()); // final subkey (key 5) mixing
-
-        ct.push_back(state);
+        state = apply_round(SPN_ENC_FINAL, state ^ sub_keys[this->rounds]);
+        ct[i] = state ^ sub_keys[this->rounds + 1];
     }
-
-    return ct;
 }
 
 // simple SPN cipher decrypt function
-std::vector<uint32_t> SPN::decrypt(const std::vector<uint32_t> ct, std::vector<uint32_t> &key) const
+void SPN::decrypt(std::span<const uint32_t> ct, std::span<uint32_t> pt, const SPNKey &key) const
 {
-    // derive round keys
-    std::vector<uint32_t> sub_keys = this->get_sub_keys(key);
+    if (pt.size() < ct.size())
+        short_output_exc();
 
-    std::vector<uint32_t> pt;
-    uint32_t state_temp, bit_idx;
+    // the middle round keys are applied after the permutation
+    const std::array<uint32_t, SPN_SUB_KEYS> &sub_keys = key.dec_keys;
 
-    for (uint32_t state: ct)
+    for (size_t i = 0; i < ct.size(); i++)
     {
-        // undo final round key
-        state ^= *(sub_keys.rbegin());
+        // undo final round key, then the inverse sbox and the permutation of round 3
+        uint32_t state = apply_round(SPN_DEC_ROUND, (ct[i] & 0xffff) ^ sub_keys[this->rounds + 1]);
 
-        // apply inverse sbox
-        state = this->apply_sbox(state, true);
+        // undo rounds 3 .. 2, the state stays permuted between the lookups
+        for (uint32_t rnum = this->rounds; rnum > 1; rnum--)
+            state = apply_round(SPN_DEC_ROUND, state ^ sub_keys[rnum]);
 
-        // undo first three rounds of simple SPN cipher
-        for (uint32_t rnum = 0; rnum < this->rounds; rnum++)
-        {
-            // XOR state with round key (3, subkeys 4, ..., 0)
-            state ^= sub_keys[this->rounds - rnum];
+        // last inverse sbox, then XOR state with round key 0
+        state = apply_round(SPN_DEC_FINAL, state ^ sub_keys[1]);
+        pt[i] = state ^ sub_keys[0];
+    }
+}
 
-            // un-permute the state bitwise (2)
-            state_temp = bit_idx = 0;
-            while (bit_idx < this->block_size)
-            {
-                if (state & (1 << bit_idx))
-                {
-                    state_temp |= (1 << pbox.at(bit_idx));
-                }
+void SPN::encrypt_batch(const uint16_t *pt, uint16_t *ct, size_t n, const SPNKey &key) const
+{
+    spn_batch_kernel(false)(pt, ct, n, key.sub_keys.data(), this->rounds);
+}
 
-                bit_idx++;
-            }
+void SPN::decrypt_batch(const uint16_t *ct, uint16_t *pt, size_t n, const SPNKey &key) const
+{
+    spn_batch_kernel(true)(ct, pt, n, key.sub_keys.data(), this->rounds);
+}
 
-            state = state_temp;
+void SPN::encrypt_batch(std::span<const uint16_t> pt, std::span<uint16_t> ct, const SPNKey &key) const
+{
+    if (ct.size() < pt.size())
+        short_output_exc();
 
-            // apply inverse s-box
-            state = this->apply_sbox(state, true);
-        }
+    this->encrypt_batch(pt.data(), ct.data(), pt.size(), key);
+}
 
-        // XOR state with round key 0
-        state ^= *(sub_keys.begin());
-        pt.push_back(state);
-    }
+void SPN::decrypt_batch(std::span<const uint16_t> ct, std::span<uint16_t> pt, const SPNKey &key) const
+{
+    if (pt.size() < ct.size())
+        short_output_exc();
 
-    return pt;
+    this->decrypt_batch(ct.data(), pt.data(), ct.size(), key);
 }
+
+#endif
@@ -0,0 +1,147 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <algorithm>
+#include "linear.h"
+#include "trail.h"
+
+/*
+success rate of the linear attack against the number of known pairs. for
+every pair count, `keys` random keys are drawn and each one is attacked with
+that many random known plaintexts; the attack succeeds when the true
+target is the unique best candidate. the trials of one point are spread
+over the worker threads, and each trial seeds its own generator from
+(seed, pairs, trial), so the results do not depend on the thread count.
+
+the approximation is the heys one, or with --trail the best one the trail
+search finds with at most two active sboxes in the last round.
+
+one CSV row per point goes to stdout:
+
+pairs,keys,success_prob,avg_rank,wall_seconds
+*/
+
+static const uint32_t DEFAULT_PAIRS[] = {250, 500, 1000, 2000, 4000, 8000, 16000, 32000};
+
+struct SweepPoint
+{
+    uint32_t successes;
+    uint64_t rank_sum;
+};
+
+static SweepPoint run_point(const SPN &spn, const LinearApprox &approx, uint32_t n_pairs, uint32_t n_keys, uint64_t seed, uint32_t n_threads)
+{
+    std::atomic<uint32_t> next(0), successes(0);
+    std::atomic<uint64_t> rank_sum(0);
+
+    auto work = [&]() {
+        std::vector<uint16_t> pts(n_pairs), cts(n_pairs);
+        uint32_t my_successes = 0;
+        uint64_t my_rank_sum = 0;
+
+        for (uint32_t trial; (trial = next++) < n_keys; )
+        {
+            std::seed_seq seq {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32), n_pairs, trial};
+            std::mt19937_64 rng(seq);
+
+            const SPNKey key(spn.get_rand_key(rng));
+            for (uint16_t &pt: pts)
+                pt = rng() & 0xffff;
+
+            spn.encrypt_batch(pts.data(), cts.data(), n_pairs, key);
+
+            const LCAScores scores = lca_target_scores(approx, pts.data(), cts.data(), n_pairs);
+            const uint32_t rank = lca_rank(scores, lca_true_target(approx, key));
+
+            my_successes += (rank == 1);
+            my_rank_sum += rank;
+        }
+
+        successes += my_successes;
+        rank_sum += my_rank_sum;
+    };
+
+    n_threads = std::max(1u, std::min(n_threads, n_keys));
+    std::vector<std::thread> workers;
+    for (uint32_t t = 1; t < n_threads; t++)
+        workers.emplace_back(work);
+
+    work();
+
+    for (std::thread &worker: workers)
+        worker.join();
+
+    return {successes.load(), rank_sum.load()};
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t n_keys = 1000;
+    uint32_t n_threads = std::thread::hardware_concurrency();
+    uint64_t seed = 1;
+    std::vector<uint32_t> pair_counts(std::begin(DEFAULT_PAIRS), std::end(DEFAULT_PAIRS));
+
+    const bool use_trail = (argc > 1) and (std::string(argv[1]) == "--trail");
+    if (use_trail)
+    {
+        argc--;
+        argv++;
+    }
+
+    try
+    {
+        if (argc > 1) n_keys = std::stoul(argv[1]);
+        if (argc > 2) n_threads = std::stoul(argv[2]);
+        if (argc > 3) seed = std::stoull(argv[3], nullptr, 0);
+
+        if (argc > 4)
+        {
+            pair_counts.clear();
+            for (int i = 4; i < argc; i++)
+                pair_counts.push_back(std::stoul(argv[i]));
+        }
+    }
+    catch (const std::exception &)
+    {
+        std::cerr << "Usage: " << argv[0] << " [--trail] [keys per point] [threads] [seed] [pairs ...]\n";
+        return 1;
+    }
+
+    if (n_keys == 0)
+    {
+        std::cerr << "at least one key per point is needed\n";
+        return 1;
+    }
+
+    const SPN spn;
+    LinearApprox approx = LCA_HEYS_APPROX;
+
+    if (use_trail)
+    {
+        LinearTrailSearch search(LinearApproxTable(spn.sbox, 4), spn.pbox);
+        approx = search.best(SPN_ROUNDS, 2, n_threads).approx();
+    }
+
+    std::cerr << "in_mask 0x" << std::hex << approx.in_mask << ", out_mask 0x" << approx.out_mask;
+    std::cerr << std::dec << ", bias " << approx.bias << "\n";
+
+    std::cout << "pairs,keys,success_prob,avg_rank,wall_seconds\n";
+
+    for (const uint32_t n_pairs: pair_counts)
+    {
+        auto start = std::chrono::steady_clock::now();
+        const SweepPoint point = run_point(spn, approx, n_pairs, n_keys, seed, n_threads);
+        auto stop = std::chrono::steady_clock::now();
+
+        std::cout << n_pairs << "," << n_keys << ",";
+        std::cout << static_cast<double>(point.successes) / n_keys << ",";
+        std::cout << static_cast<double>(point.rank_sum) / n_keys << ",";
+        std::cout << std::chrono::duration<double>(stop - start).count() << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,73 @@
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <thread>
+#include "spn.h"
+#include "trail.h"
+
+/*
+print the best linear trail through 1 ... `rounds` rounds of the SPN, each
+with its masks, bias and the active sboxes of every round, and the time the
+branch-and-bound search took.
+*/
+
+static std::string mask_hex(uint32_t mask)
+{
+    std::stringstream ss;
+    ss << "0x" << std::setfill('0') << std::setw(4) << std::hex << mask;
+
+    return ss.str();
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t rounds = SPN_ROUNDS, max_last_active = 4;
+    uint32_t n_threads = std::thread::hardware_concurrency();
+
+    try
+    {
+        if (argc > 1) rounds = std::stoul(argv[1]);
+        if (argc > 2) max_last_active = std::stoul(argv[2]);
+        if (argc > 3) n_threads = std::stoul(argv[3]);
+    }
+    catch (const std::exception &)
+    {
+        std::cerr << "Usage: " << argv[0] << " [rounds] [max active sboxes after the last round] [threads]\n";
+        return 1;
+    }
+
+    const SPN spn;
+    const LinearApproxTable lat(spn.sbox, 4);
+    LinearTrailSearch search(lat, spn.pbox);
+
+    for (uint32_t r = 1; r <= rounds; r++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        LinearTrail trail;
+
+        try
+        {
+            trail = search.best(r, (r == rounds) ? max_last_active : 4, n_threads);
+        }
+        catch (const std::exception &exc)
+        {
+            std::cerr << exc.what() << "\n";
+            return 1;
+        }
+
+        auto stop = std::chrono::steady_clock::now();
+
+        std::cout << r << " round" << (r > 1 ? "s" : "") << ": bias " << trail.approx().bias;
+        std::cout << " (" << std::chrono::duration<double, std::milli>(stop - start).count() << " ms)\n";
+
+        for (uint32_t i = 0; i < trail.masks.size(); i++)
+        {
+            std::cout << "    U_" << i + 1 << " " << mask_hex(trail.masks[i]);
+            std::cout << "  active sboxes " << active_sboxes(trail.masks[i]) << "\n";
+        }
+    }
+
+    return 0;
+}
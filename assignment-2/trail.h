@@ -0,0 +1,379 @@
+#ifndef TRAIL_H
+#define TRAIL_H
+
+#include <span>
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <stdexcept>
+#include "lat.h"
+#include "linear.h"
+
+/*
+matsui-style branch-and-bound search for the best linear characteristic
+(trail) through the first rounds of a 16-bit SPN with 4-bit sboxes.
+
+a trail is a chain of masks U_1 -> U_2 -> ... -> U_{R+1}: in round r every
+active sbox (non-zero nibble a of the U_r mask) picks an output mask b, the
+output masks form V_r and U_{r+1} = P(V_r). its correlation is the product
+of the sbox correlations c = 2 * LAT[a][b] / 16 and, by the piling-up lemma,
+the bias of the whole approximation is half of it.
+
+the search keeps bound[r], the best |correlation| over r rounds, and finds
+them one round count at a time. while extending a partial trail it prunes
+as soon as
+
+|correlation so far| * best |c| left in this round * bound[rounds left]
+
+falls below the best full trail found so far. the input mask of round 1 is
+free, so each round 1 output mask V_1 simply takes the best input for every
+active sbox. the V_1 masks are sorted by that correlation and handed out to
+worker threads in order, which stops the whole search once the next start
+cannot beat the best trail any more.
+
+for the attack the number of active sboxes in the last round (the sboxes
+whose subkey nibbles are guessed) is capped, or the mask after the last
+round is restricted to a given set of bits; either only applies to the
+mask U_{R+1} of the full-length search. ties are broken on fewer active
+last-round sboxes and then on the smaller masks, so the result does not
+depend on the number of threads.
+*/
+
+struct LinearTrail
+{
+    std::vector<uint32_t> masks;    // U_1 ... U_{R+1}
+    double correlation;
+
+    LinearApprox approx(void) const;
+};
+
+LinearApprox LinearTrail::approx(void) const
+{
+    return {this->masks.front(), this->masks.back(), this->correlation / 2};
+}
+
+class LinearTrailSearch
+{
+    private:
+        static const uint32_t BOXES = 4;
+        static const uint32_t N_MASKS = 1 << 16;
+
+        // P of nibble value x in nibble `box`: perm_nibble[box][x]
+        std::array<std::array<uint16_t, 16>, 4> perm_nibble;
+
+        // output masks b with LAT[a][b] != 0 for every a, by |c| descending
+        std::array<std::vector<std::pair<uint32_t, double>>, 16> outputs;
+        std::array<double, 16> best_out;    // max_b |c(a, b)|
+        std::array<double, 16> best_in;     // max_a |c(a, b)|
+        std::array<uint32_t, 16> arg_in;
+
+        std::vector<double> bound;
+
+        // round 1 output masks V_1 by the correlation of their best input, descending
+        std::vector<std::pair<double, uint32_t>> starts;
+
+        uint32_t permute(uint32_t) const;
+
+        struct Search;
+
+        LinearTrail search(uint32_t, uint32_t, uint32_t, uint32_t);
+
+    public:
+        LinearTrailSearch(const LinearApproxTable &, std::span<const uint8_t>);
+
+        // best trail over `rounds` rounds with at most max_last_active sboxes active after it
+        LinearTrail best(uint32_t, uint32_t = BOXES, uint32_t = std::thread::hardware_concurrency());
+
+        // best trail whose mask after the last round only has bits inside `allowed`
+        LinearTrail best_within(uint32_t, uint32_t, uint32_t = std::thread::hardware_concurrency());
+};
+
+static uint32_t active_sboxes(uint32_t mask)
+{
+    uint32_t n = 0;
+    for (uint32_t box = 0; box < 4; box++)
+        n += ((mask >> (box << 2)) & 0xf) != 0;
+
+    return n;
+}
+
+// the trail order: |correlation|, then fewer active sboxes at the end, then masks
+static bool better_trail(const LinearTrail &a, const LinearTrail &b)
+{
+    const double ca = a.correlation < 0 ? -a.correlation : a.correlation;
+    const double cb = b.correlation < 0 ? -b.correlation : b.correlation;
+
+    if (ca != cb)
+        return ca > cb;
+
+    if (active_sboxes(a.masks.back()) != active_sboxes(b.masks.back()))
+        return active_sboxes(a.masks.back()) < active_sboxes(b.masks.back());
+
+    return a.masks < b.masks;
+}
+
+LinearTrailSearch::LinearTrailSearch(const LinearApproxTable &lat, std::span<const uint8_t> pbox)
+    : bound(1, 1.0)
+{
+    if ((lat.in_bits != 4) or (lat.out_bits != 4) or (pbox.size() != 16))
+        throw std::invalid_argument("trail search needs a 4-bit sbox and a 16-bit pbox");
+
+    for (uint32_t box = 0; box < BOXES; box++)
+    {
+        for (uint32_t x = 0; x < 16; x++)
+        {
+            this->perm_nibble[box][x] = 0;
+            for (uint32_t bit = 0; bit < 4; bit++)
+                this->perm_nibble[box][x] |= ((x >> bit) & 1) << pbox[(box << 2) + bit];
+        }
+    }
+
+    this->best_in.fill(0.0);
+    this->arg_in.fill(0);
+
+    for (uint32_t a = 0; a < 16; a++)
+    {
+        this->best_out[a] = 0.0;
+
+        for (uint32_t b = 0; b < 16; b++)
+        {
+            const double c = 2.0 * lat.bias(a, b) / 16;
+            const double abs_c = c < 0 ? -c : c;
+
+            if ((a == 0) or (b == 0) or (c == 0))
+                continue;
+
+            this->outputs[a].push_back({b, c});
+            this->best_out[a] = std::max(this->best_out[a], abs_c);
+
+            if (abs_c > this->best_in[b])
+            {
+                this->best_in[b] = abs_c;
+                this->arg_in[b] = a;
+            }
+        }
+
+        std::stable_sort(this->outputs[a].begin(), this->outputs[a].end(), [](const auto &x, const auto &y) {
+            return (x.second < 0 ? -x.second : x.second) > (y.second < 0 ? -y.second : y.second);
+        });
+    }
+
+    for (uint32_t v = 1; v < N_MASKS; v++)
+    {
+        double c = 1.0;
+        for (uint32_t box = 0; box < BOXES; box++)
+        {
+            const uint32_t b = (v >> (box << 2)) & 0xf;
+            if (b) c *= this->best_in[b];
+        }
+
+        this->starts.push_back({c, v});
+    }
+
+    std::stable_sort(this->starts.begin(), this->starts.end(), [](const auto &x, const auto &y) {
+        return x.first > y.first;
+    });
+}
+
+uint32_t LinearTrailSearch::permute(uint32_t mask) const
+{
+    return this->perm_nibble[0][mask & 0xf] | this->perm_nibble[1][(mask >> 4) & 0xf]
+        | this->perm_nibble[2][(mask >> 8) & 0xf] | this->perm_nibble[3][mask >> 12];
+}
+
+/*
+one worker's depth-first search. `best_abs` is the shared bound: the
+|correlation| of the best trail any thread has found, only ever raised.
+*/
+
+struct LinearTrailSearch::Search
+{
+    const LinearTrailSearch &s;
+    const uint32_t rounds, max_last_active, allowed;
+    std::atomic<double> &best_abs;
+
+    std::vector<uint32_t> masks;
+    LinearTrail found {{}, 0.0};
+
+    // max |c(a, b)| over the outputs b of sbox `box` that keep the last mask inside `allowed`
+    std::array<std::array<double, 16>, BOXES> last_out {};
+
+    void init(void)
+    {
+        for (uint32_t box = 0; box < BOXES; box++)
+            for (uint32_t a = 1; a < 16; a++)
+                for (const auto &[b, cb]: this->s.outputs[a])
+                    if (!(this->s.permute(b << (box << 2)) & ~this->allowed))
+                        this->last_out[box][a] = std::max(this->last_out[box][a], cb < 0 ? -cb : cb);
+    }
+
+    // bound for rounds `round` onwards from its input mask, exact when `round` is the last
+    double last_bound(uint32_t round, uint32_t u) const
+    {
+        if (round != this->rounds)
+            return this->s.bound[this->rounds - round + 1];
+
+        double c = 1.0;
+        for (uint32_t box = 0; box < BOXES; box++)
+        {
+            const uint32_t a = (u >> (box << 2)) & 0xf;
+            if (a) c *= this->last_out[box][a];
+        }
+
+        return c;
+    }
+
+    bool pruned(double abs_c) const
+    {
+        return abs_c < this->best_abs.load(std::memory_order_relaxed);
+    }
+
+    void offer(double c)
+    {
+        LinearTrail trail {this->masks, c};
+        if (!this->found.masks.empty() and !better_trail(trail, this->found))
+            return;
+
+        this->found = trail;
+
+        const double abs_c = c < 0 ? -c : c;
+        double seen = this->best_abs.load();
+        while ((abs_c > seen) and !this->best_abs.compare_exchange_weak(seen, abs_c));
+    }
+
+    // sbox `box` onwards of round `round`, whose input is masks[round - 1]
+    void extend(uint32_t round, uint32_t box, uint32_t v, double c)
+    {
+        const uint32_t u = this->masks[round - 1];
+
+        while ((box < BOXES) and !((u >> (box << 2)) & 0xf))
+            box++;
+
+        if (box == BOXES)
+        {
+            this->next_round(round, v, c);
+            return;
+        }
+
+        const bool last = (round == this->rounds);
+
+        // the best the sboxes after this one can still do
+        double rest = this->s.bound[this->rounds - round];
+        for (uint32_t later = box + 1; later < BOXES; later++)
+        {
+            const uint32_t a = (u >> (later << 2)) & 0xf;
+            if (a) rest *= last ? this->last_out[later][a] : this->s.best_out[a];
+        }
+
+        const double abs_c = c < 0 ? -c : c;
+
+        for (const auto &[b, cb]: this->s.outputs[(u >> (box << 2)) & 0xf])
+        {
+            const double abs_cb = cb < 0 ? -cb : cb;
+            if (this->pruned(abs_c * abs_cb * rest))
+                break;
+
+            if (last and (this->s.permute(b << (box << 2)) & ~this->allowed))
+                continue;
+
+            this->extend(round, box + 1, v | (b << (box << 2)), c * cb);
+        }
+    }
+
+    void next_round(uint32_t round, uint32_t v, double c)
+    {
+        const uint32_t u = this->s.permute(v);
+        this->masks.push_back(u);
+
+        if (round == this->rounds)
+        {
+            if ((active_sboxes(u) <= this->max_last_active) and !(u & ~this->allowed))
+                this->offer(c);
+        }
+        else if (!this->pruned((c < 0 ? -c : c) * this->last_bound(round + 1, u)))
+            this->extend(round + 1, 0, 0, c);
+
+        this->masks.pop_back();
+    }
+};
+
+LinearTrail LinearTrailSearch::best(uint32_t rounds, uint32_t max_last_active, uint32_t n_threads)
+{
+    return this->search(rounds, max_last_active, N_MASKS - 1, n_threads);
+}
+
+LinearTrail LinearTrailSearch::best_within(uint32_t rounds, uint32_t allowed, uint32_t n_threads)
+{
+    return this->search(rounds, BOXES, allowed, n_threads);
+}
+
+LinearTrail LinearTrailSearch::search(uint32_t rounds, uint32_t max_last_active, uint32_t allowed, uint32_t n_threads)
+{
+    if (rounds == 0)
+        throw std::invalid_argument("a trail covers at least one round");
+
+    // bounds for the shorter trails first, each search using the ones before it
+    while (this->bound.size() < rounds)
+        this->bound.push_back(this->best(this->bound.size(), BOXES, n_threads).correlation);
+
+    for (double &b: this->bound)
+        b = b < 0 ? -b : b;
+
+    std::atomic<double> best_abs(0.0);
+    std::atomic<uint32_t> next(0);
+    std::mutex lock;
+    LinearTrail best {{}, 0.0};
+
+    auto work = [&]() {
+        Search search {*this, rounds, max_last_active, allowed, best_abs, {}, {{}, 0.0}, {}};
+        search.init();
+
+        for (uint32_t i; (i = next++) < this->starts.size(); )
+        {
+            const auto [c_1, v] = this->starts[i];
+            if (search.pruned(c_1 * this->bound[rounds - 1]))
+                break;
+
+            uint32_t u_1 = 0;
+            double c = 1.0;
+            for (uint32_t box = 0; box < BOXES; box++)
+            {
+                const uint32_t b = (v >> (box << 2)) & 0xf;
+                if (!b) continue;
+
+                const uint32_t a = this->arg_in[b];
+                u_1 |= a << (box << 2);
+                for (const auto &[ob, cb]: this->outputs[a])
+                    if (ob == b) c *= cb;
+            }
+
+            search.masks.assign(1, u_1);
+            search.next_round(1, v, c);
+        }
+
+        std::lock_guard<std::mutex> guard(lock);
+        if (!search.found.masks.empty() and (best.masks.empty() or better_trail(search.found, best)))
+            best = search.found;
+    };
+
+    n_threads = std::max(1u, n_threads);
+    std::vector<std::thread> workers;
+    for (uint32_t t = 1; t < n_threads; t++)
+        workers.emplace_back(work);
+
+    work();
+
+    for (std::thread &worker: workers)
+        worker.join();
+
+    if (best.masks.empty())
+        throw std::runtime_error("no trail with such a mask after the last round");
+
+    return best;
+}
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef WHT_H
+#define WHT_H
+
+#include <cstdint>
+#include <cstddef>
+
+/*
+in-place fast walsh-hadamard transform of a length 2^k sequence, unnormalised:
+out[u] = sum_x in[x] * (-1)^popcount(u & x). applying it twice multiplies by
+the length, and it turns XOR convolutions into pointwise products:
+wht(a (*) b) = wht(a) * wht(b) where (a (*) b)[t] = sum_x a[x] * b[x ^ t].
+*/
+
+template <typename T>
+void fwht(T *data, size_t n)
+{
+    for (size_t half = 1; half < n; half <<= 1)
+    {
+        for (size_t i = 0; i < n; i += half << 1)
+        {
+            for (size_t j = i; j < i + half; j++)
+            {
+                T a = data[j], b = data[j + half];
+                data[j] = a + b;
+                data[j + half] = a - b;
+            }
+        }
+    }
+}
+
+#endif
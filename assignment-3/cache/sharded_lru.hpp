@@ -0,0 +1,107 @@
+#ifndef SHARDED_LRU_HPP
+#define SHARDED_LRU_HPP
+
+#include <cstdint>
+#include <algorithm>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <vector>
+#include <utility>
+#include <unordered_map>
+
+/*
+least-recently-used cache split into independent shards, each behind its
+own mutex, so threads looking up unrelated keys rarely wait on each other.
+a key always maps to the same shard, and every shard evicts its own oldest
+entry once it holds capacity / n_shards entries.
+*/
+
+template <typename K, typename V>
+class ShardedLRU
+{
+    private:
+        typedef std::list<std::pair<K, V>> Order;
+
+        struct Shard
+        {
+            std::mutex lock;
+            Order order; // most recently used first
+            std::unordered_map<K, typename Order::iterator> index;
+        };
+
+        std::vector<Shard> shards;
+        size_t shard_capacity;
+        uint32_t shard_shift;
+
+        Shard & shard_of(const K &key)
+        {
+            uint64_t h = std::hash<K>()(key) * 0x9e3779b97f4a7c15;
+            return this->shards[this->shard_shift < 64 ? h >> this->shard_shift : 0];
+        }
+
+    public:
+        // n_shards is rounded down to a power of two
+        ShardedLRU(size_t capacity, uint32_t n_shards = 64)
+        {
+            uint32_t log_shards = 0;
+            while ((2u << log_shards) <= n_shards)
+                log_shards++;
+
+            this->shards = std::vector<Shard>(size_t(1) << log_shards);
+            this->shard_shift = 64 - log_shards;
+            this->shard_capacity = std::max<size_t>(1, capacity >> log_shards);
+        }
+
+        bool get(const K &key, V &value)
+        {
+            Shard &shard = this->shard_of(key);
+            std::lock_guard<std::mutex> guard(shard.lock);
+
+            auto it = shard.index.find(key);
+            if (it == shard.index.end())
+                return false;
+
+            shard.order.splice(shard.order.begin(), shard.order, it->second);
+            value = it->second->second;
+
+            return true;
+        }
+
+        void put(const K &key, const V &value)
+        {
+            Shard &shard = this->shard_of(key);
+            std::lock_guard<std::mutex> guard(shard.lock);
+
+            auto it = shard.index.find(key);
+            if (it != shard.index.end())
+            {
+                it->second->second = value;
+                shard.order.splice(shard.order.begin(), shard.order, it->second);
+                return;
+            }
+
+            if (shard.index.size() >= this->shard_capacity)
+            {
+                shard.index.erase(shard.order.back().first);
+                shard.order.pop_back();
+            }
+
+            shard.order.emplace_front(key, value);
+            shard.index[key] = shard.order.begin();
+        }
+
+        size_t size(void)
+        {
+            size_t total = 0;
+            for (Shard &shard: this->shards)
+            {
+                std::lock_guard<std::mutex> guard(shard.lock);
+                total += shard.index.size();
+            }
+
+            return total;
+        }
+};
+
+#endif
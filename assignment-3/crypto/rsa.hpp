@@ -2,6 +2,7 @@
 #include <ctime>
 #include <tuple>
 #include <gmp.h>
+#include "solvay_strassen.h"
 
 static void invalid_pt_exc(void)
 {
@@ -101,6 +102,10 @@ void PrivKey::get_rand_prime(mpz_t &prime, const uint32_t nbits)
     const uint32_t BUFFER_SIZE = (nbits >> 3) + bool(rem);
     uint8_t *temp_buf = new uint8_t[BUFFER_SIZE];
 
+    // error probability per prime is at most 2^-PRIME_ROUNDS
+    const uint64_t PRIME_ROUNDS = 64;
+    SolvayStrassen ss;
+
     do
     {
         for (uint32_t i = 0; i < BUFFER_SIZE; i++)
@@ -116,11 +121,11 @@ void PrivKey::get_rand_prime(mpz_t &prime, const uint32_t nbits)
 
         temp_buf[0] |= 0x01;
 
-        mpz_t temp; mpz_init(temp);
-        mpz_import(temp, BUFFER_SIZE, 1, sizeof(temp_buf[0]), 0, 0, temp_buf);
+        mpz_import(prime, BUFFER_SIZE, 1, sizeof(temp_buf[0]), 0, 0, temp_buf);
+        mpz_setbit(prime, 0);
 
-        mpz_nextprime(prime, temp);
-        mpz_clear(temp);
+        while (!ss.is_prime(prime, PRIME_ROUNDS))
+            mpz_add_ui(prime, prime, 2);
     }
     while (mpz_sizeinbase(prime, 2) != nbits);
 
@@ -0,0 +1,121 @@
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <random>
+#include <chrono>
+#include "socket/simplesocket.h"
+#include "socket/clientsocket.h"
+
+/*
+load generator for prime_server: sends <count> random odd numbers of <bits>
+bits, drawn from a pool of <distinct> values so repeats exercise the cache,
+BATCH_LINES queries per round trip, then asks the server for its counters.
+*/
+
+const uint32_t BATCH_LINES = 4096;
+const uint32_t READ_BYTES = 1 << 16;
+
+// read until `lines` newline-terminated replies have arrived
+static bool recv_lines(clientsocket *s, uint32_t lines, std::string &replies)
+{
+  std::vector<char> buf(READ_BYTES);
+  uint32_t seen = 0;
+  replies.clear();
+
+  while (seen < lines)
+  {
+    int n_read = s->read(buf.data(), READ_BYTES);
+    if (n_read <= 0)
+      return false;
+
+    for (int i = 0; i < n_read; i++)
+      seen += (buf[i] == '\n');
+
+    replies.append(buf.data(), n_read);
+  }
+
+  return true;
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc < 4)
+  {
+    std::cerr << "Usage: " << argv[0] << " <port> <count> <bits> [distinct]" << endl;
+    exit(1);
+  }
+
+  std::string hostname("0.0.0.0"); uint16_t port;
+  uint64_t count, distinct = 0; uint32_t bits;
+  std::stringstream (argv[1]) >> port;
+  std::stringstream (argv[2]) >> count;
+  std::stringstream (argv[3]) >> bits;
+  if (argc > 4) std::stringstream (argv[4]) >> distinct;
+
+  if (count == 0 || bits < 2 || bits > 64)
+  {
+    std::cerr << "count should be positive and bits between 2 and 64" << endl;
+    exit(1);
+  }
+
+  std::mt19937_64 rng(0x5eed);
+  auto draw = [&]() {
+    uint64_t n = rng();
+    if (bits < 64) n &= (uint64_t(1) << bits) - 1;
+    return n | (uint64_t(1) << (bits - 1)) | 1;
+  };
+
+  std::vector<uint64_t> pool(distinct);
+  for (uint64_t &n: pool)
+    n = draw();
+
+  clientsocket *s = new clientsocket(hostname.c_str(), port);
+  if (!s->connect())
+  {
+    std::cerr << "cannot connect to " << hostname << ":" << port << endl;
+    exit(1);
+  }
+  s->setNoDelay();
+
+  std::string batch, replies;
+  uint64_t primes = 0;
+  auto start = std::chrono::steady_clock::now();
+
+  for (uint64_t sent = 0; sent < count; )
+  {
+    uint32_t lines = std::min<uint64_t>(BATCH_LINES, count - sent);
+
+    batch.clear();
+    for (uint32_t i = 0; i < lines; i++)
+      batch += std::to_string(distinct ? pool[rng() % distinct] : draw()) + "\n";
+
+    if (s->sendNBytes((unsigned char *)batch.data(), batch.size()) < 0 ||
+        !recv_lines(s, lines, replies))
+    {
+      std::cerr << "connection lost after " << sent << " queries" << endl;
+      exit(1);
+    }
+
+    for (size_t pos = 0; (pos = replies.find("prime\n", pos)) != std::string::npos; pos++)
+      primes += (pos == 0 || replies[pos - 1] == '\n');
+
+    sent += lines;
+  }
+
+  auto stop = std::chrono::steady_clock::now();
+  double secs = std::chrono::duration<double>(stop - start).count();
+
+  std::string stats = "stats\n";
+  s->sendNBytes((unsigned char *)stats.data(), stats.size());
+  recv_lines(s, 1, stats);
+
+  std::cout << count << " queries (" << primes << " primes) in " << secs << " s, ";
+  std::cout << std::fixed << std::setprecision(0) << count / secs << " queries/sec\n";
+  std::cout << "server: " << stats;
+
+  s->close();
+  delete s;
+
+  return 0;
+}
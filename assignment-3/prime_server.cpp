@@ -0,0 +1,259 @@
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <atomic>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <cerrno>
+#include <pthread.h>
+#include "socket/simplesocket.h"
+#include "socket/serversocket.h"
+#include "cache/sharded_lru.hpp"
+#include "solvay_strassen.h"
+
+/*
+primality service: clients send decimal numbers one per line and get back
+one line per query, "prime", "composite" or "invalid", in the same order.
+a client does not have to wait for an answer before sending the next query;
+every read is answered as one batch, so many queries share a round trip.
+the line "stats" is answered with the server counters instead. a client
+that sends more than MAX_LINE_BYTES without a newline gets the line "error
+line too long" and is disconnected, so no connection can make the server
+buffer without bound.
+
+numbers below 2^64 go through the deterministic batch test and their
+verdicts are kept in a sharded LRU cache shared by all connections, larger
+numbers get MPZ_ROUNDS random solovay-strassen rounds and are not cached.
+*/
+
+const uint64_t MPZ_ROUNDS = 64;
+const uint32_t READ_BYTES = 1 << 16;
+const uint32_t MAX_LINE_BYTES = 1 << 12;
+
+enum Reply { COMPOSITE = 0, PRIME = 1, INVALID = 2, STATS = 3 };
+
+static ShardedLRU<uint64_t, uint8_t> *cache;
+static std::atomic<uint64_t> n_queries(0), n_hits(0), n_lookups(0);
+
+static bool parse_u64(const std::string &str, uint64_t &n)
+{
+  if (str.empty() || str.size() > 20 || str.find_first_not_of("0123456789") != std::string::npos)
+    return false;
+
+  errno = 0;
+  n = std::strtoull(str.c_str(), nullptr, 10);
+
+  return errno == 0;
+}
+
+static std::string stats_line(void)
+{
+  uint64_t lookups = n_lookups.load();
+  double ratio = lookups ? 100.0 * n_hits.load() / lookups : 0.0;
+
+  std::stringstream line;
+  line << "queries " << n_queries.load() << " hits " << n_hits.load();
+  line << " hit_ratio " << std::fixed << std::setprecision(1) << ratio;
+  line << "% cached " << cache->size();
+
+  return line.str();
+}
+
+/*
+answer every complete line of a batch. cache misses below 2^64 are collected
+and tested together with is_prime_batch before the replies are assembled.
+*/
+
+static void answer(SolvayStrassen &ss, const std::vector<std::string> &lines, std::string &out)
+{
+  std::vector<uint8_t> replies(lines.size());
+  std::vector<uint64_t> misses;
+  std::vector<uint32_t> miss_slots;
+  uint64_t hits = 0, lookups = 0;
+
+  mpz_t big;
+  mpz_init(big);
+
+  for (uint32_t i = 0; i < lines.size(); i++)
+  {
+    uint64_t n; uint8_t verdict;
+
+    if (lines[i] == "stats")
+      replies[i] = STATS;
+    else if (parse_u64(lines[i], n))
+    {
+      lookups++;
+      if (cache->get(n, verdict))
+      {
+        hits++;
+        replies[i] = verdict;
+      }
+      else
+      {
+        misses.push_back(n);
+        miss_slots.push_back(i);
+      }
+    }
+    else if (lines[i].find_first_not_of("0123456789") == std::string::npos &&
+             mpz_set_str(big, lines[i].c_str(), 10) == 0)
+      replies[i] = ss.is_prime(big, MPZ_ROUNDS) ? PRIME : COMPOSITE;
+    else
+      replies[i] = INVALID;
+  }
+
+  mpz_clear(big);
+
+  std::vector<uint8_t> verdicts(misses.size());
+  ss.is_prime_batch(misses.data(), verdicts.data(), misses.size());
+
+  for (uint32_t j = 0; j < misses.size(); j++)
+  {
+    replies[miss_slots[j]] = verdicts[j];
+    cache->put(misses[j], verdicts[j]);
+  }
+
+  n_queries += lines.size();
+  n_lookups += lookups;
+  n_hits += hits;
+
+  for (const uint8_t &reply: replies)
+  {
+    switch (reply)
+    {
+      case PRIME: out += "prime\n"; break;
+      case COMPOSITE: out += "composite\n"; break;
+      case INVALID: out += "invalid\n"; break;
+      case STATS: out += stats_line() + "\n"; break;
+    }
+  }
+}
+
+void * serve(void *cv)
+{
+  simplesocket *c = (simplesocket *)cv;
+  SolvayStrassen ss;
+
+  // a batch reply can go out in several writes, don't hold the tail back
+  c->setNoDelay();
+
+  std::vector<char> buf(READ_BYTES);
+  std::vector<std::string> lines;
+  std::string pending, out;
+
+  while (true)
+  {
+    int n_read = c->read(buf.data(), READ_BYTES);
+    if (n_read <= 0)
+      break;
+
+    pending.append(buf.data(), n_read);
+
+    // split off the complete lines, keep a trailing partial one for later
+    lines.clear();
+    size_t begin = 0, end;
+    while ((end = pending.find('\n', begin)) != std::string::npos)
+    {
+      size_t len = end - begin;
+      if (len && pending[end - 1] == '\r')
+        len--;
+
+      lines.emplace_back(pending, begin, len);
+      begin = end + 1;
+    }
+    pending.erase(0, begin);
+
+    const bool too_long = pending.size() > MAX_LINE_BYTES;
+    if (lines.empty() && !too_long)
+      continue;
+
+    out.clear();
+    answer(ss, lines, out);
+    if (too_long)
+      out += "error line too long\n";
+
+    if (c->sendNBytes((unsigned char *)out.data(), out.size()) < 0 || too_long)
+      break;
+  }
+
+  delete c;
+
+  return nullptr;
+}
+
+void * report(void *iv)
+{
+  uint32_t interval = *(uint32_t *)iv;
+  uint64_t last = 0;
+
+  while (true)
+  {
+    std::this_thread::sleep_for(std::chrono::seconds(interval));
+
+    uint64_t queries = n_queries.load();
+    if (queries == last)
+      continue;
+
+    std::cout << std::fixed << std::setprecision(0);
+    std::cout << (double)(queries - last) / interval << " queries/sec, ";
+    std::cout << stats_line() << std::endl;
+    last = queries;
+  }
+
+  return nullptr;
+}
+
+int main(int argc, char *argv[])
+{
+  if (argc < 2)
+  {
+    std::cerr << "Usage: " << argv[0] << " <port> [cache entries] [report seconds]" << endl;
+    exit(1);
+  }
+
+  uint16_t port; uint64_t capacity = 1 << 20; uint32_t interval = 5;
+  std::stringstream (argv[1]) >> port;
+  if (argc > 2) std::stringstream (argv[2]) >> capacity;
+  if (argc > 3) std::stringstream (argv[3]) >> interval;
+
+  if (capacity == 0 || interval == 0)
+  {
+    std::cerr << "cache entries and report seconds should be positive" << endl;
+    exit(1);
+  }
+
+  cache = new ShardedLRU<uint64_t, uint8_t>(capacity);
+
+  try
+  {
+    serversocket *s = new serversocket(port);
+    std::cout << "prime server listening on port " << port << ", caching up to ";
+    std::cout << capacity << " verdicts\n\n";
+
+    pthread_t reporter;
+    pthread_create(&reporter, nullptr, report, (void *)&interval);
+
+    while (true)
+    {
+      simplesocket *c = s->accept();
+      if (c == nullptr)
+        continue;
+
+      pthread_t th;
+      pthread_create(&th, nullptr, serve, (void *)c);
+      pthread_detach(th);
+    }
+
+    s->close();
+    delete s;
+  }
+  catch (const std::exception &exc)
+  {
+    std::cerr << "server closed!\n\n";
+    return 1;
+  }
+
+  delete cache;
+
+  return 0;
+}
@@ -16,6 +16,7 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <netdb.h>
 #include <arpa/inet.h>
 #include <cassert>
@@ -97,6 +98,12 @@ public:
     return recvNBytes(buf, len, true);
   }
 
+  /// @brief Send small writes immediately instead of coalescing them (Nagle).
+  void setNoDelay (bool on = true) {
+    int flag = on;
+    setsockopt (_socketfd, IPPROTO_TCP, TCP_NODELAY, (void *) &flag, sizeof (flag));
+  }
+
   void setTimeout (int timeout) {
     if (timeout > 0)
       _timeout = timeout;